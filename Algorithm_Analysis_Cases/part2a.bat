@@ -1,4 +1,8 @@
 main test1_fcfs_p1c.txt output1_fcfs_p1c.txt 0 0 0
 main test1_fcfs_p1d.txt output1_fcfs_p1d.txt 0 0 0
 main test2_priority.txt output2_priority.txt 1 0 0
-main test3_rr_100ms.txt output3_rr_100ms.txt 2 100 0
\ No newline at end of file
+main test3_rr_100ms.txt output3_rr_100ms.txt 2 100 0
+main test1_fcfs_p1c.txt output1_fcfs_p1c.txt 0 0 0 --event
+main test1_fcfs_p1d.txt output1_fcfs_p1d.txt 0 0 0 --event
+main test2_priority.txt output2_priority.txt 1 0 0 --event
+main test3_rr_100ms.txt output3_rr_100ms.txt 2 100 0 --event
\ No newline at end of file
@@ -36,4 +36,64 @@ main test9.txt output9.txt 0 0 0
 
 main test10.txt output10_part1.txt 0 0 1
 main test10.txt output10_part2.txt 0 0 2
-main test10.txt output10.txt 0 0 0
\ No newline at end of file
+main test10.txt output10.txt 0 0 0
+
+main test11.txt output11_fifo3.txt 0 0 5 --frames 3 --replacement fifo --page-trace trace11.txt
+main test11.txt output11_fifo4.txt 0 0 5 --frames 4 --replacement fifo --page-trace trace11.txt
+main test11.txt output11_lru3.txt 0 0 5 --frames 3 --replacement lru --page-trace trace11.txt
+main test11.txt output11_lru4.txt 0 0 5 --frames 4 --replacement lru --page-trace trace11.txt
+main test11.txt output11_clock4.txt 0 0 5 --frames 4 --replacement clock --page-trace trace11.txt
+main test11.txt output11_arc4.txt 0 0 5 --frames 4 --replacement arc --page-trace trace11.txt
+
+main test12.txt output12.txt 0 0 1
+main test12.txt output12_swap.txt 0 0 1 --swap
+
+main test1.txt output1_part1.txt 0 0 1 --event
+main test1.txt output1_part2.txt 0 0 2 --event
+main test1.txt output1.txt 0 0 0 --event
+
+main test2.txt output2_part1.txt 0 0 1 --event
+main test2.txt output2_part2.txt 0 0 2 --event
+main test2.txt output2.txt 0 0 0 --event
+
+main test3.txt output3_part1.txt 0 0 1 --event
+main test3.txt output3_part2.txt 0 0 2 --event
+main test3.txt output3.txt 0 0 0 --event
+
+main test4.txt output4_part1.txt 0 0 1 --event
+main test4.txt output4_part2.txt 0 0 2 --event
+main test4.txt output4.txt 0 0 0 --event
+
+main test5.txt output5_part1.txt 0 0 1 --event
+main test5.txt output5_part2.txt 0 0 2 --event
+main test5.txt output5.txt 0 0 0 --event
+
+main test6.txt output6_part1.txt 0 0 1 --event
+main test6.txt output6_part2.txt 0 0 2 --event
+main test6.txt output6.txt 0 0 0 --event
+
+main test7.txt output7_part1.txt 0 0 1 --event
+main test7.txt output7_part2.txt 0 0 2 --event
+main test7.txt output7.txt 0 0 0 --event
+
+main test8.txt output8_part1.txt 0 0 1 --event
+main test8.txt output8_part2.txt 0 0 2 --event
+main test8.txt output8.txt 0 0 0 --event
+
+main test9.txt output9_part1.txt 0 0 1 --event
+main test9.txt output9_part2.txt 0 0 2 --event
+main test9.txt output9.txt 0 0 0 --event
+
+main test10.txt output10_part1.txt 0 0 1 --event
+main test10.txt output10_part2.txt 0 0 2 --event
+main test10.txt output10.txt 0 0 0 --event
+
+main test11.txt output11_fifo3.txt 0 0 5 --frames 3 --replacement fifo --page-trace trace11.txt --event
+main test11.txt output11_fifo4.txt 0 0 5 --frames 4 --replacement fifo --page-trace trace11.txt --event
+main test11.txt output11_lru3.txt 0 0 5 --frames 3 --replacement lru --page-trace trace11.txt --event
+main test11.txt output11_lru4.txt 0 0 5 --frames 4 --replacement lru --page-trace trace11.txt --event
+main test11.txt output11_clock4.txt 0 0 5 --frames 4 --replacement clock --page-trace trace11.txt --event
+main test11.txt output11_arc4.txt 0 0 5 --frames 4 --replacement arc --page-trace trace11.txt --event
+
+main test12.txt output12.txt 0 0 1 --event
+main test12.txt output12_swap.txt 0 0 1 --swap --event
\ No newline at end of file
@@ -0,0 +1,2 @@
+gcc -std=c17 -O2 -pthread -o main ../main.c ../sim.c -lm
+main --sweep test2.txt sweep2.txt sweep2_results.csv
\ No newline at end of file
@@ -2,4 +2,9 @@ main test1.txt output1_FCFS.txt 0 0 0
 main test1.txt output1_priority.txt 1 0 0
 main test1.txt output1_roundrobin.txt 2 100 0
 main test1.txt output1_MemPartition1.txt 0 0 1
-main test1.txt output1_MemPartition2.txt 0 0 2
\ No newline at end of file
+main test1.txt output1_MemPartition2.txt 0 0 2
+main test1.txt output1_FCFS.txt 0 0 0 --event
+main test1.txt output1_priority.txt 1 0 0 --event
+main test1.txt output1_roundrobin.txt 2 100 0 --event
+main test1.txt output1_MemPartition1.txt 0 0 1 --event
+main test1.txt output1_MemPartition2.txt 0 0 2 --event
\ No newline at end of file
@@ -2,4 +2,9 @@ main test2.txt output2_FCFS.txt 0 0 0
 main test2.txt output2_priority.txt 1 0 0
 main test2.txt output2_roundrobin.txt 2 100 0
 main test2.txt output2_MemPartition1.txt 0 0 1
-main test2.txt output2_MemPartition2.txt 0 0 2
\ No newline at end of file
+main test2.txt output2_MemPartition2.txt 0 0 2
+main test2.txt output2_FCFS.txt 0 0 0 --event
+main test2.txt output2_priority.txt 1 0 0 --event
+main test2.txt output2_roundrobin.txt 2 100 0 --event
+main test2.txt output2_MemPartition1.txt 0 0 1 --event
+main test2.txt output2_MemPartition2.txt 0 0 2 --event
\ No newline at end of file
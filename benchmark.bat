@@ -0,0 +1,2 @@
+gcc -std=c17 -O2 -pthread -o main main.c sim.c -lm
+main --benchmark benchmark_results.csv
\ No newline at end of file
@@ -11,702 +11,2045 @@
  *
  * This program generates an executable file that simulates a small
  * OS kernel, which can be used for performance analysis of three
- * scheduling algorithms.
+ * scheduling algorithms. The simulator itself is the library in sim.c,
+ * this file is the command line program that runs it on files.
  */
 
 
 
+#define _POSIX_C_SOURCE 200809L    // For mmap with a strict C17 compiler
+
 #include <stdlib.h>
+#include <stddef.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <time.h>
+#include <math.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "sim.h"
 
 
 
-// Global Time Variable
-int time_elapsed = 0;
+// Output file that is flushed if the program ends on an error
+FILE *output_file = NULL;
 
+// Binary transition log that is closed if the program ends on an error
+struct binary_writer *transition_log = NULL;
 
 
-// Structure implementation
-typedef struct pcb {		// Defines the process control block struct
-    int pid;
-    int arrival_time;
-    int remaining_cpu_time;
-    int cpu_arrival_time;
-    int io_frequency;
-    int io_duration;
-    int time_until_io;
-    int priority;
-    int size_of_process;
-    int base_memory_location;
-    struct pcb *next;
-} pcb_t;
 
-typedef struct {      		// Defines the queue struct that will contain pcbs
-    pcb_t *front;
-    pcb_t *rear;
-    int size;
-} queue_t;
+// Structure implementation
+typedef struct {            // Defines an input file that is parsed in one pass straight out of memory
+    char *name;
+    char *data;
+    size_t size;
+    size_t position;        // Offset of the next character to parse
+    int line;               // Line of the next character, counting from 1
+    int errors;             // Number of malformed lines found so far
+    _Bool mapped;           // Whether data is mapped from the file rather than read into the heap
+    int format;             // Text, or one of the binary formats detected from the header
+    int last_time;          // Time of the last binary record read, the records store the difference
+    int last_arrival_time;  // Arrival time of the last process read when streaming, which must not go backwards
+    int record_size;        // Size of the records of a binary workload, which depends on its version
+} input_t;
+
+typedef struct binary_writer {  // Defines a binary file that records are appended to through a moving memory map
+    char *name;
+    unsigned char *window;  // Part of the file that is mapped, records are written straight into it
+    size_t window_offset;   // Offset in the file of the start of the window
+    size_t position;        // Offset in the window of the next byte
+    long long num_records;
+    int last_time;          // Time of the last record, each record stores the difference
+#ifdef _WIN32
+    FILE *file;             // Without mmap, the window is a buffer that is written out when it is full
+#else
+    int fd;
+#endif
+} binary_writer_t;
+enum { TEXT_FORMAT, WORKLOAD_FORMAT, LOG_FORMAT, SAMPLES_FORMAT, SNAPSHOT_FORMAT };    // Formats of the files read by open_input
+enum { BINARY_VERSION = 1, BINARY_HEADER_SIZE = 16, WORKLOAD_RECORD_SIZE = 36, LOG_RECORD_SIZE = 9 };
+enum { WORKLOAD_VERSION = 2, OLD_WORKLOAD_RECORD_SIZE = 28 };   // Version 1 workloads have no deadline or period
+enum { BINARY_WINDOW_SIZE = 1 << 20 };  // Size of the part of a binary file mapped at once, a multiple of the page size
+#define WORKLOAD_MAGIC "KSWL"           // First four bytes of a binary workload
+#define LOG_MAGIC "KSTL"                // First four bytes of a binary transition log
+#define SAMPLES_MAGIC "KSTS"            // First four bytes of a time series file
+enum { SAMPLE_COLUMNS = 7 };            // Fields of a sim_sample_t, each stored as a column
+enum { MAX_CHECKPOINTS = 16 };          // Most snapshots a simulation can save on its way
+typedef struct {            // Defines the settings given on the command line or on a line of a sweep
+    sim_config_t config;
+    _Bool stream;           // Read each process from the input file just before it arrives
+    _Bool binary;           // Write the transitions to a binary transition log instead of the text output
+    char *process_log;      // CSV file of the times of each process, NULL if there is none
+    char *samples;          // Time series file, NULL if there is none
+    int num_checkpoints;
+    int checkpoint_times[MAX_CHECKPOINTS];  // Times in ms at which to save a snapshot, in increasing order
+    char *checkpoint_files[MAX_CHECKPOINTS];
+} options_t;
+
+typedef struct {            // Defines the simulations of a parameter sweep, shared by the threads that run them
+    sim_t **sims;
+    int num_sims;
+    atomic_int next_sim;    // Next simulation for a thread to run
+} sweep_t;
+
+enum { END_TIME_METRIC, THROUGHPUT_METRIC, TURNAROUND_METRIC, WAIT_METRIC, P99_TURNAROUND_METRIC,
+       P99_RESPONSE_METRIC, CPU_UTILIZATION_METRIC, PAGE_FAULTS_METRIC, MISSED_DEADLINES_METRIC,
+       NUM_MONTE_CARLO_METRICS };   // Metrics whose distribution over the replicas a Monte Carlo run reports
+
+typedef struct {            // Defines the replicas of a Monte Carlo run, shared by the threads that run them
+    const sim_process_t *processes;     // Workload that each replica perturbs a copy of
+    int num_processes;
+    const sim_config_t *config;
+    double spread;          // Most a CPU time or I/O duration is scaled up or down by, as a fraction
+    unsigned int seed;      // Replica i is perturbed with seed + i
+    int num_replicas;
+    atomic_int next_replica;    // Next replica for a thread to run
+    double *values[NUM_MONTE_CARLO_METRICS];    // One column per metric, holding the value of each replica
+} monte_carlo_t;
+
+#ifdef _WIN32
+typedef LPTHREAD_START_ROUTINE thread_function_t;
+#else
+typedef void *(*thread_function_t)(void *);
+#endif
+
+
+
+// Binary files
+
+void put_le32(unsigned char *bytes, unsigned int value) {
+    /*
+     * Stores a 32 bit value in four bytes, least significant byte first, whatever the byte order of the host.
+     */
 
+    bytes[0] = value & 0xff;
+    bytes[1] = (value >> 8) & 0xff;
+    bytes[2] = (value >> 16) & 0xff;
+    bytes[3] = (value >> 24) & 0xff;
+}
 
+int get_le32(const unsigned char *bytes) {
+    /*
+     * Reads a 32 bit value stored by put_le32.
+     */
 
-// Allocating and initializing functions for structs
+    return (int) ((unsigned int) bytes[0] | ((unsigned int) bytes[1] << 8) | ((unsigned int) bytes[2] << 16) |
+                  ((unsigned int) bytes[3] << 24));
+}
 
-queue_t *new_queue(void) {
+int put_varint(unsigned char *bytes, int value) {
     /*
-     * Allocates a queue struct on the heap and returns a pointer
-     * to it. Initializes the front and rear pointers to null and the
-     * queue size to 0.
+     * Stores a value in 1 to 5 bytes and returns how many. The value is zigzag encoded so that small negative
+     * values are short too, then stored seven bits per byte, with the top bit set on every byte but the last.
      */
 
-    queue_t *queue = malloc(sizeof(queue_t));     // Allocate new queue_t struct on the heap
-    assert(queue != NULL);
+    unsigned int zigzag = ((unsigned int) value << 1) ^ (unsigned int) -(value < 0);
+    int length = 0;
+    while (zigzag >= 0x80) {
+        bytes[length++] = (zigzag & 0x7f) | 0x80;
+        zigzag >>= 7;
+    }
+    bytes[length++] = zigzag;
+    return length;
+}
 
-    queue->front = NULL;				// Initialize elements of queue (the queue_t struct)
-    queue->rear = NULL; 
-    queue->size = 0;
+int get_varint(const unsigned char *bytes, int *length) {
+    /*
+     * Reads a value stored by put_varint, and adds the number of bytes it took to length.
+     */
 
-    return queue;
+    unsigned int zigzag = 0;
+    int shift = 0;
+    int i = 0;
+    do {
+        zigzag |= (unsigned int) (bytes[i] & 0x7f) << shift;
+        shift += 7;
+    } while ((bytes[i++] & 0x80) && (shift < 35));
+    *length += i;
+    return (int) (zigzag >> 1) ^ -(int) (zigzag & 1);
 }
 
-pcb_t *new_pcb(int pid, int arrival_time, int total_cpu_time, int io_freq, int io_dur, int priority, int process_size) {
+void map_window(binary_writer_t *writer) {
     /*
-     * Takes all of the inputted information about a process and stores it in a pcb_t struct allocated
-     * on the heap. Returns a pointer to the pcb struct.
+     * Grows the file to the end of the window at window_offset and maps the window. On Windows the window is
+     * only a buffer, so there is nothing to do.
      */
 
-    pcb_t *pcb = malloc(sizeof(pcb_t));
-    assert(pcb != NULL);
+#ifndef _WIN32
+    int result = ftruncate(writer->fd, writer->window_offset + BINARY_WINDOW_SIZE);
+    assert(result == 0);
+    writer->window = mmap(NULL, BINARY_WINDOW_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, writer->fd,
+                          writer->window_offset);
+    assert(writer->window != MAP_FAILED);
+#endif
+}
 
-    pcb->pid = pid;
-    pcb->arrival_time = arrival_time;
-    pcb->remaining_cpu_time = total_cpu_time;
-    pcb->cpu_arrival_time = 0;
-    pcb->io_frequency = io_freq;
-    pcb->io_duration = io_dur;
-    pcb->next = NULL;
-    pcb->priority = priority;
-    pcb->time_until_io = io_freq;
-    pcb->base_memory_location = -1;          // Measured in Mb
-    pcb->size_of_process = process_size;     // Measured in Mb
+void write_bytes(binary_writer_t *writer, const unsigned char *bytes, size_t count) {
+    /*
+     * Appends count bytes to a binary file, moving the window on to the next part of the file when it is full.
+     */
 
-    return pcb;
+    while (count > 0) {
+        if (writer->position == BINARY_WINDOW_SIZE) {
+#ifdef _WIN32
+            fwrite(writer->window, 1, BINARY_WINDOW_SIZE, writer->file);
+#else
+            munmap(writer->window, BINARY_WINDOW_SIZE);
+#endif
+            writer->window_offset += BINARY_WINDOW_SIZE;
+            writer->position = 0;
+            map_window(writer);
+        }
+        size_t chunk = BINARY_WINDOW_SIZE - writer->position;
+        chunk = (count < chunk) ? count : chunk;
+        memcpy(writer->window + writer->position, bytes, chunk);
+        writer->position += chunk;
+        bytes += chunk;
+        count -= chunk;
+    }
 }
 
+void close_binary_writer(binary_writer_t *writer) {
+    /*
+     * Cuts a binary file down to the bytes that were written, fills in the number of records in its header and
+     * closes it.
+     */
 
+    unsigned char count[8];
+    put_le32(count, (unsigned int) (writer->num_records & 0xffffffff));
+    put_le32(count + 4, (unsigned int) (writer->num_records >> 32));
+
+#ifdef _WIN32
+    fwrite(writer->window, 1, writer->position, writer->file);
+    fseek(writer->file, 8, SEEK_SET);
+    fwrite(count, 1, sizeof(count), writer->file);
+    fclose(writer->file);
+    free(writer->window);
+#else
+    munmap(writer->window, BINARY_WINDOW_SIZE);
+    int result = ftruncate(writer->fd, writer->window_offset + writer->position);
+    assert(result == 0);
+    result = (int) pwrite(writer->fd, count, sizeof(count), 8);
+    assert(result == sizeof(count));
+    close(writer->fd);
+#endif
+    free(writer);
+}
 
-// Queue functions
+void exit_on_error(void) {
+    /*
+     * Ends the program after an error has been printed. The buffered output file is flushed first, so that the
+     * transitions written up to that point are not lost, and a binary transition log is closed so that its
+     * header counts the records written so far.
+     */
+
+    fflush(stdout);
+    if (output_file != NULL) {
+        fflush(output_file);
+    }
+    if (transition_log != NULL) {
+        binary_writer_t *log = transition_log;
+        transition_log = NULL;      // An error while closing it ends the program straight away
+        close_binary_writer(log);
+    }
+    abort();
+}
 
-void enqueue(queue_t *queue, pcb_t *pcb) {
-    /* 
-     * Adds a previously allocated node to the end of the queue pointed to by queue.
+binary_writer_t *open_binary_writer(char file_name[], const char magic[]) {
+    /*
+     * Creates a binary file, erasing it if it exists, and writes its header: the four byte magic of its format,
+     * the format version and the number of records, which is filled in by close_binary_writer.
      */
 
-    if (queue->front == NULL) {		// If the queue is empty, add node at the front
-        queue->front = pcb;
-    } else {
-        queue->rear->next = pcb;	//If the queue has other elements, add node at the end
+    binary_writer_t *writer = calloc(1, sizeof(binary_writer_t));
+    assert(writer != NULL);
+    writer->name = file_name;
+
+#ifdef _WIN32
+    writer->file = fopen(file_name, "wb");
+    writer->window = malloc(BINARY_WINDOW_SIZE);
+    _Bool opened = (writer->file != NULL) && (writer->window != NULL);
+#else
+    writer->fd = open(file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    _Bool opened = (writer->fd != -1);
+#endif
+    if (!opened) {
+        printf("File was not opened");
+        exit_on_error();
     }
+    map_window(writer);
+
+    unsigned char header[BINARY_HEADER_SIZE] = {0};
+    memcpy(header, magic, 4);
+    put_le32(header + 4, (strcmp(magic, WORKLOAD_MAGIC) == 0) ? WORKLOAD_VERSION : BINARY_VERSION);
+    write_bytes(writer, header, BINARY_HEADER_SIZE);
 
-    queue->rear = pcb;     			// Set the rear pointer to point to the new end of the queue
-    queue->size += 1;				// Increase queue size
+    return writer;
 }
 
-void dequeue(queue_t *queue, _Bool deallocate) {
+void write_log_record(binary_writer_t *writer, int transition_identifier, int time, int pid) {
     /*
-     * If the queue pointed to by queue is empty, returns false.
-     * If the queue has one or more nodes, removes the front node
-     * and returns true. If the queue ends up with only one node, 
-     * makes sure that the front and rear pointers in the queue 
-     * struct both point to the one node in the list.
+     * Appends a transition to a binary transition log. Each record holds the time since the previous
+     * transition, the pid and the transition identifier used by sim_write_transition.
      */
 
-    if (queue->size == 0) {    					// If the queue is empty, cannot dequeue
-        printf("Queue is empty, cannot dequeue.");
-        assert(false);
-    }
-     pcb_t *pcb_to_delete = queue->front;       // Creates a temporary pointer to the front node
+    unsigned char record[LOG_RECORD_SIZE];
+    put_le32(record, (unsigned int) time - (unsigned int) writer->last_time);
+    put_le32(record + 4, (unsigned int) pid);
+    record[8] = (unsigned char) transition_identifier;
+    write_bytes(writer, record, LOG_RECORD_SIZE);
+    writer->last_time = time;
+    writer->num_records++;
+}
 
-    if (deallocate) { 							// Determines whether node is deallocated or removed from list
-        queue->front = queue->front->next;		// Remove the node from the queue, set new front
-        free(pcb_to_delete);          			// Free the front node
-        pcb_to_delete = NULL;
-    } else {
-        queue->front = queue->front->next;
-        pcb_to_delete->next = NULL;
-        
-    }
+void write_workload_record(binary_writer_t *writer, const sim_process_t *process) {
+    /*
+     * Appends a process to a binary workload. Each record holds the nine fields of a line of the text input,
+     * with the arrival time stored as the difference from the arrival time of the previous record.
+     */
+
+    unsigned char record[WORKLOAD_RECORD_SIZE];
+    put_le32(record, (unsigned int) process->pid);
+    put_le32(record + 4, (unsigned int) process->arrival_time - (unsigned int) writer->last_time);
+    put_le32(record + 8, (unsigned int) process->total_cpu_time);
+    put_le32(record + 12, (unsigned int) process->io_frequency);
+    put_le32(record + 16, (unsigned int) process->io_duration);
+    put_le32(record + 20, (unsigned int) process->priority);
+    put_le32(record + 24, (unsigned int) process->size_of_process);
+    put_le32(record + 28, (unsigned int) process->deadline);
+    put_le32(record + 32, (unsigned int) process->period);
+    write_bytes(writer, record, WORKLOAD_RECORD_SIZE);
+    writer->last_time = process->arrival_time;
+    writer->num_records++;
+}
 
-    if (queue->front == NULL){					// If list is now empty, set front and rear pointers
-        queue->rear = NULL;
-    }
 
-    queue->size -= 1;     						// Decrease queue size
+void write_sample_block(binary_writer_t *writer, const sim_sample_t samples[], int num_samples) {
+    /*
+     * Appends a block of samples to a time series file. The block holds the number of samples, then each
+     * column in turn: its size in bytes, then the difference of each value from the one before it as varints.
+     * Queue sizes and memory change little between samples, so most values take a single byte. The first
+     * value of a column is stored as is, so each block can be read on its own.
+     */
+
+    static const size_t columns[SAMPLE_COLUMNS] = {
+        offsetof(sim_sample_t, time), offsetof(sim_sample_t, new_size), offsetof(sim_sample_t, ready_size),
+        offsetof(sim_sample_t, waiting_size), offsetof(sim_sample_t, busy_cpus),
+        offsetof(sim_sample_t, used_portions), offsetof(sim_sample_t, free_usable_memory)};
+
+    unsigned char *column = malloc(5 * (size_t) num_samples);
+    assert(column != NULL);
+    unsigned char size[4];
+    put_le32(size, (unsigned int) num_samples);
+    write_bytes(writer, size, sizeof(size));
+    for (int c = 0; c < SAMPLE_COLUMNS; c++) {
+        int length = 0;
+        int previous = 0;
+        for (int i = 0; i < num_samples; i++) {
+            int value = *(const int *) ((const char *) &samples[i] + columns[c]);
+            length += put_varint(column + length, (int) ((unsigned int) value - (unsigned int) previous));
+            previous = value;
+        }
+        put_le32(size, (unsigned int) length);
+        write_bytes(writer, size, sizeof(size));
+        write_bytes(writer, column, length);
+    }
+    free(column);
+    writer->num_records += num_samples;
 }
 
 
 
 // Functions for writing to an output file
 
-void erase_write_file(char writeFile[]) {
+FILE *open_write_file(char write_file[]) {
     /*
-     * This function erases the contents of the output file, if it exists.
+     * This function opens the output file once for the whole simulation, erasing its contents if it exists.
+     * The file is given a large buffer so that the transitions are written to disk in big blocks instead of
+     * one line at a time. The buffer is flushed when the file is closed at the end of main, or by
+     * exit_on_error if the program ends on an error.
      */
 
-    FILE *f1 = fopen(writeFile, "w");       // Open the file in write mode, deleting any text that was in the file
+    static char buffer[1 << 20];
+
+    FILE *f1 = fopen(write_file, "w");       // Open the file in write mode, deleting any text that was in the file
     if (f1 == NULL) {
         printf("File was not opened");
-        assert(false);
-    }
-    fclose(f1);
-    f1 = NULL;
-}
-
-void write_transition(int transition_identifier, int pid, char write_file[]) {
-    /**
-     * Write details about a transition between states to a file. Transition type is determined by 
-     * the int transition_type.
-     * - 0 is new to ready (admitted)
-     * - 1 is ready to running (scheduler dispatch)
-     * - 2 is running to waiting (I/O or event wait)
-     * - 3 is waiting to ready (I/O or event completion)
-     * - 4 is running to ready (interrupt)
-     * - 5 is running to terminated (exit)
-     */
-    
-    // Open file specified by writeFile. Print out some transition information.
-    FILE *f2 = fopen(write_file, "a");
-    if (f2 == NULL) {
-        printf("File was not opened");
-        assert(false);
-    }
-    fprintf(f2, "%-14d %-14d ", time_elapsed, pid);
-    //fprintf(f2, "%d %d ", time, old_state->front->pid);
-
-    // These if and else statements determine which states are being transitioned between and write
-    // the corresponding states to the file pointer to by f. The commented out fprintf statements
-    // can be used instead if you want the output file to be less formatted.
-    if ((transition_identifier > 5) || (transition_identifier < 0)) {
-        printf("Incorrect transition identifier");
-        assert(false);
-    } else if (transition_identifier == 0) {
-        fprintf(f2, "NEW            READY\n\n");  
-        //fprintf(f2, "NEW READY\n");
-    } else if (transition_identifier == 1) {
-        fprintf(f2, "READY          RUNNING\n\n");
-        //fprintf(f2, "READY RUNNING\n");
-    } else if (transition_identifier == 2) {
-        fprintf(f2, "RUNNING        WAITING\n\n");
-        //fprintf(f2, "RUNNING WAITING\n");
-    } else if (transition_identifier == 3) {
-        fprintf(f2, "WAITING        READY\n\n");
-        //fprintf(f2, "WAITING READY\n");
-    } else if (transition_identifier == 4) {
-        fprintf(f2, "RUNNING        READY\n\n");
-        //fprintf(f2, "RUNNING READY\n");
-    } else {
-        fprintf(f2, "RUNNING        TERMINATED\n\n");
-        //fprintf(f2, "RUNNING TERMINATED \n");
+        exit_on_error();
     }
-    fclose(f2);    					// Close the file pointed to by f2.
-    f2 = NULL;
+    setvbuf(f1, buffer, _IOFBF, sizeof(buffer));
 
-    // Display transition details in the terminal (for debugging)
-    //printf("Transition Time: %d, ", (time));
-    //printf("Pid: %d\n\n", (old_state->front->pid));
+    output_file = f1;
+    return f1;
 }
 
-void transition(int transition_identifier, queue_t *old_state, queue_t *new_state, char write_file[]) {
-    /**
-     * Perform a transition between the states provided in old_state and 
-     * new_state. The transition type is determined by the int transition_type:
-     * - 0 is new to ready (admitted)
-     * - 1 is ready to running (scheduler dispatch)
-     * - 2 is running to waiting (I/O or event wait)
-     * - 3 is waiting to ready (I/O or event completion)
-     * - 4 is running to ready (interrupt)
-     * - 5 is running to terminated (exit)
-     * The process is moved from one queue to the next.
+void write_metric(FILE *write_file, const char *format, ...) {
+    /*
+     * Prints a metric in the terminal and writes it to the output file. A binary transition log has no output
+     * file (write_file is NULL), so the metric is only printed.
      */
-    
-    write_transition(transition_identifier, old_state->front->pid, write_file);
 
-    // Move the process from the old state to the new state
-    enqueue(new_state, old_state->front);
-    dequeue(old_state, false);
+    va_list arguments;
+    va_start(arguments, format);
+    vprintf(format, arguments);
+    va_end(arguments);
+    if (write_file != NULL) {
+        va_start(arguments, format);
+        vfprintf(write_file, format, arguments);
+        va_end(arguments);
+    }
 }
 
+// Input file parsing
 
+input_t *open_input(char file_name[]) {
+    /*
+     * Maps the input file into memory so that it can be parsed in one pass without copying it. Where mmap is
+     * not available, the file is read into the heap instead.
+     */
 
-// Schedulers
+    input_t *input = calloc(1, sizeof(input_t));
+    assert(input != NULL);
+    input->name = file_name;
+    input->line = 1;
+    input->format = TEXT_FORMAT;
+    input->last_arrival_time = INT_MIN;
+
+#ifdef _WIN32
+    FILE *file = fopen(file_name, "rb");
+    assert(file != NULL);
+    fseek(file, 0, SEEK_END);
+    input->size = ftell(file);
+    rewind(file);
+    input->data = malloc(input->size + 1);
+    assert(input->data != NULL);
+    assert(fread(input->data, 1, input->size, file) == input->size);
+    fclose(file);
+#else
+    int fd = open(file_name, O_RDONLY);
+    assert(fd != -1);
+    struct stat file_status;
+    assert(fstat(fd, &file_status) == 0);
+    input->size = file_status.st_size;
+    if (input->size > 0) {
+        input->data = mmap(NULL, input->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        assert(input->data != MAP_FAILED);
+        posix_madvise(input->data, input->size, POSIX_MADV_SEQUENTIAL);   // Parsed pages can be dropped
+        input->mapped = true;
+    }
+    close(fd);
+#endif
+
+    // Binary files are recognized by their header, the records start right after it
+    if (input->size >= BINARY_HEADER_SIZE) {
+        if (memcmp(input->data, WORKLOAD_MAGIC, 4) == 0) {
+            input->format = WORKLOAD_FORMAT;
+        } else if (memcmp(input->data, LOG_MAGIC, 4) == 0) {
+            input->format = LOG_FORMAT;
+        } else if (memcmp(input->data, SAMPLES_MAGIC, 4) == 0) {
+            input->format = SAMPLES_FORMAT;
+        } else if (memcmp(input->data, SIM_SNAPSHOT_MAGIC, 4) == 0) {
+            input->format = SNAPSHOT_FORMAT;    // Read by sim_restore, which checks the version itself
+        }
+    }
+    if (input->format == WORKLOAD_FORMAT) {
+        int version = get_le32((unsigned char *) input->data + 4);
+        if ((version != 1) && (version != WORKLOAD_VERSION)) {
+            printf("\nERROR >>> %s is a binary workload of version %d, only versions 1 and %d can be read\n",
+                   file_name, version, WORKLOAD_VERSION);
+            exit_on_error();
+        }
+        input->record_size = (version == 1) ? OLD_WORKLOAD_RECORD_SIZE : WORKLOAD_RECORD_SIZE;
+        input->position = BINARY_HEADER_SIZE;
+    } else if ((input->format != TEXT_FORMAT) && (input->format != SNAPSHOT_FORMAT)) {
+        if (get_le32((unsigned char *) input->data + 4) != BINARY_VERSION) {
+            printf("\nERROR >>> %s is a binary file of version %d, only version %d can be read\n", file_name,
+                   get_le32((unsigned char *) input->data + 4), BINARY_VERSION);
+            exit_on_error();
+        }
+        input->position = BINARY_HEADER_SIZE;
+    }
+
+    return input;
+}
 
-void fcfs_scheduler(int transition_type, queue_t *old_state, queue_t *new_state, char write_file[]) {
-    /**
-     * This First-come first-Serve (FCFS) scheduler processes queued processes in order of their arrival.
+void close_input(input_t *input) {
+    /*
+     * Unmaps (or frees) an input file opened by open_input.
      */
 
-    // Move the process at the front of the new queue into the ready queue
-    transition(transition_type, old_state, new_state, write_file);
+#ifdef _WIN32
+    free(input->data);
+#else
+    if (input->mapped) {
+        munmap(input->data, input->size);
+    }
+#endif
+    free(input);
 }
 
-void external_priorities_scheduler(int transition_type, queue_t *old_state, queue_t *new_state, char write_file[]) {
-    /**
-     * This priority-based scheduler sorts the processes in the ready queue based on their priority.
-     * This makes it so that the CPU is allocated to processes with the highest priority first.
+_Bool parse_int(input_t *input, int *value) {
+    /*
+     * Parses the next integer on the current line, skipping the spaces before it. Returns false if the next
+     * thing on the line is not an integer that fits in an int.
      */
 
-    // If the ready queue is empty, the process being scheduled can just em enqueued to the ready queue
-    if (new_state->size == 0) {
-        transition(transition_type, old_state, new_state, write_file);
+    while ((input->position < input->size) &&
+           ((input->data[input->position] == ' ') || (input->data[input->position] == '\t') ||
+            (input->data[input->position] == '\r'))) {
+        input->position++;
+    }
 
-    // If the ready queue contains other processes, the process being scheduled must be inserted into the queue
-    // according to its priority.
-    } else {
-        pcb_t *prev = NULL;
-        pcb_t *curr = new_state->front;
-        pcb_t *process_to_schedule = old_state->front;
-        _Bool scheduled = false;
-        for (int i = 0; i < new_state->size; i++) {                 // Iterate through the processes in the ready queue
-            if (curr->priority > process_to_schedule->priority) {   // Insert the process at the correct location in the queue
-                dequeue(old_state, false);
-                process_to_schedule->next = curr;
-                scheduled = true;
-                new_state->size++;
-                write_transition(transition_type, process_to_schedule->pid, write_file);
-                if (i == 0) {
-                    new_state->front = process_to_schedule;
-                } else {
-                    prev->next = process_to_schedule;
-                }
+    _Bool negative = false;
+    if ((input->position < input->size) &&
+        ((input->data[input->position] == '-') || (input->data[input->position] == '+'))) {
+        negative = (input->data[input->position] == '-');
+        input->position++;
+    }
+
+    long long result = 0;
+    size_t start = input->position;
+    while ((input->position < input->size) && (input->data[input->position] >= '0') &&
+           (input->data[input->position] <= '9')) {
+        result = result * 10 + (input->data[input->position] - '0');
+        if (result > 2147483648LL) {
+            return false;
+        }
+        input->position++;
+    }
+    if (input->position == start) {
+        return false;
+    }
+    result = negative ? -result : result;
+    if (result > 2147483647LL) {
+        return false;
+    }
+
+    // The number has to end where the field does
+    if ((input->position < input->size) && (input->data[input->position] != ' ') &&
+        (input->data[input->position] != '\t') && (input->data[input->position] != '\r') &&
+        (input->data[input->position] != '\n')) {
+        return false;
+    }
+    *value = (int) result;
+    return true;
+}
+
+_Bool read_process(input_t *input, sim_process_t *process) {
+    /*
+     * Parses the next process in the input file into process, skipping blank lines. Returns false once the
+     * end of the file is reached. Lines that do not hold seven integers, optionally followed by a deadline and
+     * a period, are reported by their line number and counted in input->errors, and parsing carries on with
+     * the next line. A binary workload is decoded one record at a time instead, where line counts the records.
+     */
+
+    if (input->format == WORKLOAD_FORMAT) {
+        int record_size = input->record_size;
+        input->line = (int) ((input->position - BINARY_HEADER_SIZE) / record_size) + 1;
+        if (input->position + record_size > input->size) {
+            if (input->position < input->size) {
+                printf("\nERROR >>> Record %d of %s is cut off\n", input->line, input->name);
+                input->errors++;
+            }
+            return false;
+        }
+        const unsigned char *record = (const unsigned char *) input->data + input->position;
+        input->last_time = (int) ((unsigned int) input->last_time + (unsigned int) get_le32(record + 4));
+        process->pid = get_le32(record);
+        process->arrival_time = input->last_time;
+        process->total_cpu_time = get_le32(record + 8);
+        process->io_frequency = get_le32(record + 12);
+        process->io_duration = get_le32(record + 16);
+        process->priority = get_le32(record + 20);
+        process->size_of_process = get_le32(record + 24);
+        process->deadline = (record_size == WORKLOAD_RECORD_SIZE) ? get_le32(record + 28) : 0;
+        process->period = (record_size == WORKLOAD_RECORD_SIZE) ? get_le32(record + 32) : 0;
+        input->position += record_size;
+        return true;
+    }
+
+    while (true) {
+        // Skip blank lines
+        while ((input->position < input->size) &&
+               ((input->data[input->position] == ' ') || (input->data[input->position] == '\t') ||
+                (input->data[input->position] == '\r') || (input->data[input->position] == '\n'))) {
+            if (input->data[input->position] == '\n') {
+                input->line++;
+            }
+            input->position++;
+        }
+        if (input->position >= input->size) {
+            return false;
+        }
+
+        // Seven fields, then the deadline and the period if the line goes on
+        int fields[9] = {0};
+        _Bool valid = true;
+        for (int i = 0; (i < 9) && valid; i++) {
+            while ((i >= 7) && (input->position < input->size) &&
+                   ((input->data[input->position] == ' ') || (input->data[input->position] == '\t') ||
+                    (input->data[input->position] == '\r'))) {
+                input->position++;
+            }
+            if ((i >= 7) && ((input->position == input->size) || (input->data[input->position] == '\n'))) {
                 break;
             }
-            prev = curr;
-            curr = curr->next;
+            valid = parse_int(input, &fields[i]);
+        }
+        while ((input->position < input->size) &&
+               ((input->data[input->position] == ' ') || (input->data[input->position] == '\t') ||
+                (input->data[input->position] == '\r'))) {
+            input->position++;
+        }
+        if ((input->position < input->size) && (input->data[input->position] != '\n')) {
+            valid = false;
+        }
+
+        if (valid) {
+            process->pid = fields[0];
+            process->arrival_time = fields[1];
+            process->total_cpu_time = fields[2];
+            process->io_frequency = fields[3];
+            process->io_duration = fields[4];
+            process->priority = fields[5];
+            process->size_of_process = fields[6];
+            process->deadline = fields[7];
+            process->period = fields[8];
+            return true;
         }
 
-        // If the process was not scheduled by this point, scheduled is false.
-        // This means that the process is the lowest priority in the queue so it must be enqueued to the ready queue
-        if (!scheduled) {
-            transition(transition_type, old_state, new_state, write_file);
+        printf("\nERROR >>> Line %d of %s should hold seven integers: pid, arrival time, CPU time, I/O frequency, "
+               "I/O duration, priority and memory, then optionally a deadline and a period\n", input->line,
+               input->name);
+        input->errors++;
+        while ((input->position < input->size) && (input->data[input->position] != '\n')) {
+            input->position++;
         }
     }
 }
 
-void round_robin_scheduler(int transition_type, queue_t *old_state, queue_t *new_state, char write_file[]) {
-    /**
-     * Round-robin (RR) scheduling algorithm is similar to FCFS scheduling in that it allocates the CPU to processes
-     * in the order that they arrive. The difference is that it interrupts the CPU after a process has been using the
-     * CPU for a certain amount of time and moves the process back to the end of the ready queue. The amount of time
-     * that each process can have the CPU at one time is specified by the quantum, the quantum is implemented in main.
-     */
 
-    transition(transition_type, old_state, new_state, write_file);
-}
 
-void scheduler(int transition_type, int scheduler_type, queue_t *old_state, queue_t *new_state, char write_file[]) {
-    /**
-     * This function determines which scheduler should be used based on a parameter passed into the program in the terminal.
+// Converting between text and binary files
+
+void write_process_line(FILE *output, const sim_process_t *process) {
+    /*
+     * Writes a process as a line of a text input file. The deadline and the period are only written if the
+     * process has either, so that workloads without them keep the seven columns.
      */
 
-    if (scheduler_type == 0) {
-        fcfs_scheduler(transition_type, old_state, new_state, write_file);
-    } else if (scheduler_type == 1) {
-        external_priorities_scheduler(transition_type, old_state, new_state, write_file);
-    } else if (scheduler_type == 2) {
-        round_robin_scheduler(transition_type, old_state, new_state, write_file);
+    fprintf(output, "%d %d %d %d %d %d %d", process->pid, process->arrival_time, process->total_cpu_time,
+            process->io_frequency, process->io_duration, process->priority, process->size_of_process);
+    if ((process->deadline != 0) || (process->period != 0)) {
+        fprintf(output, " %d %d", process->deadline, process->period);
     }
+    fprintf(output, "\n");
 }
 
+_Bool read_transition_line(input_t *input, int *transition_identifier, int *time, int *pid) {
+    /*
+     * Parses the next transition of a text output file, skipping the header, the memory metrics and the
+     * metrics at the end, which are the lines that do not start with a time and a pid. Returns false once the
+     * end of the file is reached.
+     */
 
+    // Old and new state of each transition identifier, as written by sim_write_transition
+    static const char *states[6][2] = {{"NEW", "READY"}, {"READY", "RUNNING"}, {"RUNNING", "WAITING"},
+                                       {"WAITING", "READY"}, {"RUNNING", "READY"}, {"RUNNING", "TERMINATED"}};
 
-// Memory Management
+    while (input->position < input->size) {
+        char words[2][16] = {"", ""};
+        _Bool valid = parse_int(input, time) && parse_int(input, pid);
+        for (int word = 0; (word < 2) && valid; word++) {
+            while ((input->position < input->size) && (input->data[input->position] == ' ')) {
+                input->position++;
+            }
+            int length = 0;
+            while ((input->position < input->size) && (input->data[input->position] >= 'A') &&
+                   (input->data[input->position] <= 'Z') && (length < 15)) {
+                words[word][length++] = input->data[input->position++];
+            }
+            words[word][length] = '\0';
+        }
 
-_Bool allocate_memory(pcb_t *process, int memory[][2], int num_portions, char write_file[]) {
-    /**
-     * This function returns true if the memory requirments have been successfully allocated to
-	 * memory hole. Otherwise it returns false. This function also prints out information about
-     * each process that has memory allocated to it.
-     */
+        // Move on to the next line whether or not this one held a transition
+        while ((input->position < input->size) && (input->data[input->position] != '\n')) {
+            input->position++;
+        }
+        input->position++;
+        input->line++;
 
-    int current_address = 0;
-    _Bool allocated = false;
+        for (int i = 0; (i < 6) && valid; i++) {
+            if ((strcmp(words[0], states[i][0]) == 0) && (strcmp(words[1], states[i][1]) == 0)) {
+                *transition_identifier = i;
+                return true;
+            }
+        }
+    }
+    return false;
+}
 
-    // Variable initialization for memory metrics
-    int total_used_memory = 0;
-    int num_used_portions = 0;
-    int total_free_memory;
-    int free_usable_memory = 0;
+void convert_file(char in_file[], char out_file[]) {
+    /*
+     * Converts a workload or a transition log between its text and its binary format. The format of in_file
+     * is recognized from its contents: binary files are converted to text and text files to binary. A text
+     * file starting with the "Time" header is a transition log, any other text file is a workload. Only the
+     * transitions of a text log are converted, the memory metrics and the metrics at the end are left out.
+     * A time series file is converted to CSV, one line per sample.
+     */
 
-    // Iterate through memory portions to see if any is large enought for the process
-    for (int i = 0; i < num_portions; i++) {
-        // This takes care of allocating the memory portion to the process if possible
-        if ((memory[i][1] == 0) && (memory[i][0] >= process->size_of_process) && (!allocated)) {
-            memory[i][1] = process->size_of_process;
-            process->base_memory_location = current_address;
-            allocated = true;
+    input_t *input = open_input(in_file);
+    sim_process_t process;
+
+    if (input->format == SNAPSHOT_FORMAT) {
+        printf("\nERROR >>> %s is a snapshot, which has no text format and can only be resumed from\n", in_file);
+        exit_on_error();
+    } else if (input->format == WORKLOAD_FORMAT) {
+        FILE *output = open_write_file(out_file);
+        while (read_process(input, &process)) {
+            write_process_line(output, &process);
         }
-        // This computes the memory metrics
-        if (memory[i][1] != 0) {
-            total_used_memory += memory[i][1];
-            num_used_portions++;
-        } else {
-            free_usable_memory += memory[i][0];
+        fclose(output);
+        output_file = NULL;
+    } else if (input->format == LOG_FORMAT) {
+        FILE *output = open_write_file(out_file);
+        fprintf(output, "%-14s %-14s %-14s %-14s\n\n", "Time", "PID", "Old State", "New State");
+        int time = 0;
+        while (input->position + LOG_RECORD_SIZE <= input->size) {
+            const unsigned char *record = (const unsigned char *) input->data + input->position;
+            time = (int) ((unsigned int) time + (unsigned int) get_le32(record));
+            sim_write_transition(output, record[8], time, get_le32(record + 4));
+            input->position += LOG_RECORD_SIZE;
+        }
+        fclose(output);
+        output_file = NULL;
+    } else if (input->format == SAMPLES_FORMAT) {
+        FILE *output = open_write_file(out_file);
+        fprintf(output, "time,new,ready,waiting,busy_cpus,used_portions,free_usable_memory\n");
+        const unsigned char *data = (const unsigned char *) input->data;
+        input->position += 8;   // Sample interval and number of columns
+        int *values = NULL;
+        while (input->position + 4 <= input->size) {
+            int num_samples = get_le32(data + input->position);
+            input->position += 4;
+            values = realloc(values, ((size_t) num_samples * SAMPLE_COLUMNS + 1) * sizeof(int));
+            assert(values != NULL);
+            for (int c = 0; c < SAMPLE_COLUMNS; c++) {
+                int length = get_le32(data + input->position);
+                input->position += 4;
+                int value = 0;
+                int read = 0;
+                for (int i = 0; i < num_samples; i++) {
+                    int difference = get_varint(data + input->position + read, &read);
+                    value = (int) ((unsigned int) value + (unsigned int) difference);
+                    values[i * SAMPLE_COLUMNS + c] = value;
+                }
+                input->position += length;
+            }
+            for (int i = 0; i < num_samples; i++) {
+                int *sample = &values[i * SAMPLE_COLUMNS];
+                fprintf(output, "%d,%d,%d,%d,%d,%d,%d\n", sample[0], sample[1], sample[2], sample[3], sample[4],
+                        sample[5], sample[6]);
+            }
+        }
+        free(values);
+        fclose(output);
+        output_file = NULL;
+    } else if ((input->size >= 4) && (memcmp(input->data, "Time", 4) == 0)) {
+        binary_writer_t *writer = open_binary_writer(out_file, LOG_MAGIC);
+        int transition_identifier;
+        int time;
+        int pid;
+        while (read_transition_line(input, &transition_identifier, &time, &pid)) {
+            write_log_record(writer, transition_identifier, time, pid);
+        }
+        close_binary_writer(writer);
+    } else {
+        binary_writer_t *writer = open_binary_writer(out_file, WORKLOAD_MAGIC);
+        while (read_process(input, &process)) {
+            write_workload_record(writer, &process);
         }
-        // current_address holds the current position in memory
-        current_address += memory[i][0];
+        close_binary_writer(writer);
     }
-    // More memory metric computing
-    total_free_memory = current_address - total_used_memory;
 
-    // If the process is allocated memory, write the memory metrics to the output file
-    if (allocated) {
-        FILE *f6 = fopen(write_file, "a");
-        assert(f6 != NULL);
-        fprintf(f6, "MEMORY HAS BEEN ALLOCATED TO PROCESS %d\n", process->pid);
-        fprintf(f6, "Total used memory: %d Mb\n", total_used_memory);
-        fprintf(f6, "Used memory portions: %d\nFree memory portions: %d\n", num_used_portions, num_portions - num_used_portions);
-        fprintf(f6, "Total amount of free memory: %d Mb\n", total_free_memory);
-        fprintf(f6, "Total amount of free usable memory: %d Mb\n\n", free_usable_memory);
-        fclose(f6);
+    if (input->errors > 0) {
+        exit_on_error();
     }
-    return allocated;
+    close_input(input);
 }
 
-void deallocate_memory(pcb_t *process, int memory[][2], int num_portions) {
-    /**
-     * This function deallocates memory allocated by the allocate_memory function.
+
+
+// Workloads and settings
+
+sim_process_t *read_workload(input_t *input, int *num_processes) {
+    /*
+     * Parses every process of the input file into an array that grows as it goes. The array only holds the
+     * values read from the file, each simulation gives the processes their own pcbs when they arrive.
      */
-    
-    int current_address = 0;
 
-    // Iterate through memory portions
-    for (int i = 0; i < num_portions; i++) {
-        // If the memory portion is the one allocated to the process stored in process, deallocate it
-        if ((current_address == process->base_memory_location) && (memory[i][1] != 0)) {
-            process->base_memory_location = -1;
-            memory[i][1] = 0;
-            break;
+    int capacity = 1024;
+    sim_process_t *processes = malloc(capacity * sizeof(sim_process_t));
+    assert(processes != NULL);
+    *num_processes = 0;
+    while (read_process(input, &processes[*num_processes])) {
+        if (++*num_processes == capacity) {
+            capacity *= 2;
+            processes = realloc(processes, capacity * sizeof(sim_process_t));
+            assert(processes != NULL);
         }
-        current_address += memory[i][0];
     }
+    if (input->errors > 0) {
+        exit_on_error();
+    }
+    return processes;
+}
+
+_Bool read_streamed_process(void *input, sim_process_t *process) {
+    /*
+     * Gives a streaming simulation the next process of the input file, which has to be in order of arrival time
+     * since each process is only read just before it arrives.
+     */
+
+    input_t *stream = input;
+    _Bool has_process = read_process(stream, process);
+    if (stream->errors > 0) {
+        exit_on_error();
+    }
+    if (has_process && (process->arrival_time < stream->last_arrival_time)) {
+        printf("\nERROR >>> Line %d of %s arrives before the line above it, streaming needs the input "
+               "in order of arrival time\n", stream->line, stream->name);
+        exit_on_error();
+    }
+    if (has_process) {
+        stream->last_arrival_time = process->arrival_time;
+    }
+    return has_process;
 }
 
+sim_t *restore_snapshot(char file_name[], const sim_config_t *config) {
+    /*
+     * Resumes the simulation saved in a snapshot, carrying on from where it was saved under the settings in
+     * config, which may differ from the ones it was saved under.
+     */
+
+    FILE *file = fopen(file_name, "rb");
+    if (file == NULL) {
+        printf("\nERROR >>> Could not open the snapshot %s\n", file_name);
+        exit_on_error();
+    }
+    sim_t *sim = sim_restore(file, config);
+    fclose(file);
+    if (sim == NULL) {
+        exit_on_error();
+    }
+    return sim;
+}
+
+void save_checkpoint(sim_t *sim, char file_name[]) {
+    /*
+     * Writes a snapshot of the simulation as it is now to file_name, removing all previous writing in it.
+     */
+
+    FILE *file = fopen(file_name, "wb");
+    if (file == NULL) {
+        printf("\nERROR >>> Could not open the checkpoint %s\n", file_name);
+        exit_on_error();
+    }
+    if (!sim_save(sim, file) || (fclose(file) != 0)) {
+        printf("\nERROR >>> Could not write the checkpoint %s\n", file_name);
+        exit_on_error();
+    }
+}
 
+void log_transition(void *log, int transition_identifier, int time, int pid) {
+    /*
+     * Appends a transition of a simulation to its binary transition log.
+     */
 
-// Error handling
+    write_log_record(log, transition_identifier, time, pid);
+}
 
-void error_handling(pcb_t *processes[], int num_processes, int memory[], int num_memory_portions, _Bool use_memory_management) {
+void log_samples(void *file, const sim_sample_t samples[], int num_samples) {
     /*
-     * This function is designed to catch any problematic values in the input text file and print descriptive
-     * error statements. It does not prevent any errors caused by an incorrectly formatted input file, only
-     * accounts for situations where an input value could caused the program to enter an infinite loop or other
-     * problematic situation.
+     * Appends the samples of a simulation to its time series file as one block.
      */
 
-    // Find the biggest memory portion
-    int biggest_portion = 0;
-    if (use_memory_management) {
-        for (int i = 0; i < num_memory_portions; i++) {
-            if (memory[i] > biggest_portion) {
-            biggest_portion = memory[i];
+    write_sample_block(file, samples, num_samples);
+}
+
+void parse_options(options_t *options, int argc, char *argv[]) {
+    /*
+     * Fills in the settings of a simulation from its arguments: the scheduler type, the time quantum and the
+     * memory management mode, followed by the optional arguments. Settings that are not given keep the defaults
+     * of sim_default_config.
+     */
+
+    if (argc < 3) {
+        printf("Incorrect number of arguments");
+        exit_on_error();
+    }
+
+    // Optional arguments follow the required ones
+    sim_config_t *config = &options->config;
+    sim_default_config(config);
+    options->stream = false;
+    options->binary = false;
+    options->process_log = NULL;
+    options->samples = NULL;
+    options->num_checkpoints = 0;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--event") == 0) {
+            config->event_driven = true;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            options->stream = true;
+        } else if (strcmp(argv[i], "--binary") == 0) {
+            options->binary = true;
+        } else if ((strcmp(argv[i], "--process-log") == 0) && (i + 1 < argc)) {
+            options->process_log = argv[++i];
+        } else if ((strcmp(argv[i], "--samples") == 0) && (i + 1 < argc)) {
+            options->samples = argv[++i];
+        } else if ((strcmp(argv[i], "--checkpoint") == 0) && (i + 2 < argc)) {
+            if (options->num_checkpoints == MAX_CHECKPOINTS) {
+                printf("There can be at most %d checkpoints", MAX_CHECKPOINTS);
+                exit_on_error();
+            }
+            int time = atoi(argv[++i]);
+            if (time < 0) {
+                printf("The time of a checkpoint cannot be negative");
+                exit_on_error();
+            }
+
+            // Keep the checkpoints in the order they are reached
+            int j = options->num_checkpoints++;
+            for (; (j > 0) && (options->checkpoint_times[j - 1] > time); j--) {
+                options->checkpoint_times[j] = options->checkpoint_times[j - 1];
+                options->checkpoint_files[j] = options->checkpoint_files[j - 1];
+            }
+            options->checkpoint_times[j] = time;
+            options->checkpoint_files[j] = argv[++i];
+        } else if ((strcmp(argv[i], "--sample-interval") == 0) && (i + 1 < argc)) {
+            config->sample_interval = atoi(argv[++i]);
+            if (config->sample_interval < 1) {
+                printf("The sample interval must be at least 1 ms");
+                exit_on_error();
+            }
+        } else if ((strcmp(argv[i], "--io-devices") == 0) && (i + 1 < argc)) {
+            config->io_devices = atoi(argv[++i]);
+            if (config->io_devices < 0) {
+                printf("The number of I/O devices cannot be negative");
+                exit_on_error();
+            }
+        } else if ((strcmp(argv[i], "--cpus") == 0) && (i + 1 < argc)) {
+            config->num_cpus = atoi(argv[++i]);
+            if (config->num_cpus < 1) {
+                printf("There must be at least one CPU");
+                exit_on_error();
+            }
+        } else if ((strcmp(argv[i], "--fit") == 0) && (i + 1 < argc)) {
+            i++;
+            if (strcmp(argv[i], "first") == 0) {
+                config->fit = FIRST_FIT;
+            } else if (strcmp(argv[i], "best") == 0) {
+                config->fit = BEST_FIT;
+            } else if (strcmp(argv[i], "next") == 0) {
+                config->fit = NEXT_FIT;
+            } else if (strcmp(argv[i], "worst") == 0) {
+                config->fit = WORST_FIT;
+            } else {
+                printf("Unknown fit %s, use first, best, next or worst", argv[i]);
+                exit_on_error();
+            }
+        } else if ((strcmp(argv[i], "--memory-size") == 0) && (i + 1 < argc)) {
+            config->memory_size = atoi(argv[++i]);
+            if (config->memory_size < 1) {
+                printf("The memory size must be at least 1 Mb");
+                exit_on_error();
+            }
+        } else if ((strcmp(argv[i], "--frames") == 0) && (i + 1 < argc)) {
+            config->num_frames = atoi(argv[++i]);
+            if (config->num_frames < 1) {
+                printf("There must be at least one frame");
+                exit_on_error();
+            }
+        } else if ((strcmp(argv[i], "--page-size") == 0) && (i + 1 < argc)) {
+            config->page_size = atoi(argv[++i]);
+            if (config->page_size < 1) {
+                printf("The page size must be at least 1 Mb");
+                exit_on_error();
+            }
+        } else if ((strcmp(argv[i], "--replacement") == 0) && (i + 1 < argc)) {
+            i++;
+            if (strcmp(argv[i], "fifo") == 0) {
+                config->replacement = FIFO_REPLACEMENT;
+            } else if (strcmp(argv[i], "lru") == 0) {
+                config->replacement = LRU_REPLACEMENT;
+            } else if (strcmp(argv[i], "clock") == 0) {
+                config->replacement = CLOCK_REPLACEMENT;
+            } else if (strcmp(argv[i], "arc") == 0) {
+                config->replacement = ARC_REPLACEMENT;
+            } else {
+                printf("Unknown replacement policy %s, use fifo, lru, clock or arc", argv[i]);
+                exit_on_error();
+            }
+        } else if ((strcmp(argv[i], "--fault-time") == 0) && (i + 1 < argc)) {
+            config->fault_time = atoi(argv[++i]);
+            if (config->fault_time < 1) {
+                printf("A page fault must take at least 1 ms");
+                exit_on_error();
+            }
+        } else if ((strcmp(argv[i], "--access-time") == 0) && (i + 1 < argc)) {
+            config->access_time = atoi(argv[++i]);
+            if (config->access_time < 0) {
+                printf("The memory access time cannot be negative");
+                exit_on_error();
             }
+        } else if ((strcmp(argv[i], "--page-trace") == 0) && (i + 1 < argc)) {
+            config->page_trace = argv[++i];
+        } else if ((strcmp(argv[i], "--levels") == 0) && (i + 1 < argc)) {
+            config->num_levels = atoi(argv[++i]);
+            if ((config->num_levels < 1) || (config->num_levels > MAX_LEVELS)) {
+                printf("The MLFQ must have 1 to %d levels", MAX_LEVELS);
+                exit_on_error();
+            }
+        } else if ((strcmp(argv[i], "--level-quanta") == 0) && (i + 1 < argc)) {
+            char *quantum = argv[++i];      // Comma separated quanta from the top level down
+            for (int level = 0; (quantum != NULL) && (level < MAX_LEVELS); level++) {
+                config->level_quanta[level] = atoi(quantum);
+                if (config->level_quanta[level] < 1) {
+                    printf("The quantum of level %d must be at least 1 ms", level);
+                    exit_on_error();
+                }
+                quantum = strchr(quantum, ',');
+                quantum = (quantum != NULL) ? quantum + 1 : NULL;
+            }
+        } else if ((strcmp(argv[i], "--latency") == 0) && (i + 1 < argc)) {
+            config->target_latency = atoi(argv[++i]);
+            if (config->target_latency < 1) {
+                printf("The target latency must be at least 1 ms");
+                exit_on_error();
+            }
+        } else if ((strcmp(argv[i], "--granularity") == 0) && (i + 1 < argc)) {
+            config->min_granularity = atoi(argv[++i]);
+            if (config->min_granularity < 1) {
+                printf("The minimum granularity must be at least 1 ms");
+                exit_on_error();
+            }
+        } else if ((strcmp(argv[i], "--alpha") == 0) && (i + 1 < argc)) {
+            config->burst_alpha = atof(argv[++i]);
+            if ((config->burst_alpha < 0) || (config->burst_alpha > 1)) {
+                printf("The burst prediction weight must be between 0 and 1");
+                exit_on_error();
+            }
+        } else if ((strcmp(argv[i], "--initial-burst") == 0) && (i + 1 < argc)) {
+            config->initial_burst = atoi(argv[++i]);
+            if (config->initial_burst < 0) {
+                printf("The initial burst prediction cannot be negative");
+                exit_on_error();
+            }
+        } else if (strcmp(argv[i], "--oracle") == 0) {
+            config->oracle_burst = true;
+        } else if (strcmp(argv[i], "--swap") == 0) {
+            config->swapping = true;
+        } else if ((strcmp(argv[i], "--swap-time") == 0) && (i + 1 < argc)) {
+            config->swap_time = atoi(argv[++i]);
+            if (config->swap_time < 0) {
+                printf("The swap time cannot be negative");
+                exit_on_error();
+            }
+        } else if ((strcmp(argv[i], "--boost") == 0) && (i + 1 < argc)) {
+            config->boost_interval = atoi(argv[++i]);
+            if (config->boost_interval < 0) {
+                printf("The priority boost interval cannot be negative");
+                exit_on_error();
+            }
+        } else {
+            printf("Unknown option %s", argv[i]);
+            exit_on_error();
         }
     }
 
+    // Only sample if there is a file to write the samples to, every 100 ms unless told otherwise
+    if (options->samples == NULL) {
+        config->sample_interval = 0;
+    } else if (config->sample_interval == 0) {
+        config->sample_interval = 100;
+    }
+
+    // Manage inputs, the simulation only uses the quantum for the round robin and MLFQ schedulers
+    config->scheduler_type = atoi(argv[0]);
+    config->quantum = atoi(argv[1]);
+    if ((config->scheduler_type < 0) || (config->scheduler_type >= NUM_SCHEDULERS)) {
+        printf("Unknown scheduler type %d, use 0 to %d", config->scheduler_type, NUM_SCHEDULERS - 1);
+        exit_on_error();
+    }
+    if ((config->scheduler_type == 3) && (config->quantum < 1)) {
+        printf("The quantum of the MLFQ scheduler must be at least 1 ms");
+        exit_on_error();
+    }
 
-    _Bool exit = false;
+    // Translates the memory management argument, 0 indicates that memory management is not used
+    config->memory_mode = atoi(argv[2]);
+    if ((config->memory_mode < 0) || (config->memory_mode >= NUM_MEMORY_MODES)) {
+        printf("Unknown memory management mode %d, use 0 to %d", config->memory_mode, NUM_MEMORY_MODES - 1);
+        exit_on_error();
+    }
+    if ((config->memory_mode == 4) && ((config->memory_size & (config->memory_size - 1)) != 0)) {
+        printf("The memory size of the buddy system must be a power of two");
+        exit_on_error();
+    }
+    if (config->swapping && ((config->memory_mode < 1) || (config->memory_mode > 4))) {
+        printf("Swapping needs a partitioned memory, use memory management mode 1 to 4");
+        exit_on_error();
+    }
+    if (options->stream && (options->num_checkpoints > 0)) {
+        printf("A streamed simulation cannot be checkpointed, its processes are not all known yet");
+        exit_on_error();
+    }
+}
 
-    // Iterate through all of the processes in the input file
-    for (int i = 0; i < num_processes; i++) {
+_Bool parse_distribution(char name[], int *type) {
+    /*
+     * Translates the name of a distribution of generated times, returns false if there is no such distribution.
+     */
 
-        // Make sure that no process requires more memory than the largest memory portion
-        if (((processes[i]->size_of_process) > biggest_portion) && use_memory_management) {
-            printf("\nERROR >>> Process %d requires %d Mb of memory\n", processes[i]->pid, processes[i]->size_of_process);
-            printf("There is no memory portion large enough to hold the process as the largest portion is %d Mb\n", biggest_portion);
-            exit = true;
-        }
+    if (strcmp(name, "constant") == 0) {
+        *type = CONSTANT_DISTRIBUTION;
+    } else if (strcmp(name, "uniform") == 0) {
+        *type = UNIFORM_DISTRIBUTION;
+    } else if (strcmp(name, "exponential") == 0) {
+        *type = EXPONENTIAL_DISTRIBUTION;
+    } else {
+        return false;
+    }
+    return true;
+}
 
-        // Make sure that all process inputs except pid and priority are positive
-        if ((processes[i]->arrival_time < 0) || (processes[i]->remaining_cpu_time < 0) || (processes[i]->io_frequency < 0) || 
-            (processes[i]->io_duration < 0) || (processes[i]->size_of_process < 0)) {
-                printf("\nERROR >>> Process %d has an invalid negative input\n", processes[i]->pid);
-                exit = true;
-            }
+int parse_generator_option(sim_generator_t *generator, int argc, char *argv[], int i) {
+    /*
+     * Parses the workload generator option starting at argv[i] into generator. Returns the index of the last
+     * argument of the option, or -1 if argv[i] is not a generator option.
+     */
 
-        // Make sure that CPU burst time is not 0
-        if (processes[i]->remaining_cpu_time == 0) {
-            printf("\nERROR >>> Process %d has an invalid CPU burst time of 0\n", processes[i]->pid);
-            exit = true;
+    sim_distribution_t *distribution = NULL;
+    if ((strcmp(argv[i], "--seed") == 0) && (i + 1 < argc)) {
+        generator->seed = (unsigned int) strtoul(argv[++i], NULL, 10);
+    } else if ((strcmp(argv[i], "--arrivals") == 0) && (i + 1 < argc)) {
+        i++;
+        if (strcmp(argv[i], "poisson") == 0) {
+            generator->arrivals = POISSON_ARRIVALS;
+        } else if (strcmp(argv[i], "bursty") == 0) {
+            generator->arrivals = BURSTY_ARRIVALS;
+        } else {
+            printf("Unknown arrivals %s, use poisson or bursty", argv[i]);
+            exit_on_error();
         }
+    } else if ((strcmp(argv[i], "--interarrival-time") == 0) && (i + 1 < argc)) {
+        generator->interarrival_time = atof(argv[++i]);
+    } else if ((strcmp(argv[i], "--burst-size") == 0) && (i + 1 < argc)) {
+        generator->burst_size = atof(argv[++i]);
+    } else if ((strcmp(argv[i], "--cpu-time") == 0) && (i + 2 < argc)) {
+        distribution = &generator->cpu_time;
+    } else if ((strcmp(argv[i], "--io-frequency") == 0) && (i + 2 < argc)) {
+        distribution = &generator->io_frequency;
+    } else if ((strcmp(argv[i], "--io-duration") == 0) && (i + 2 < argc)) {
+        distribution = &generator->io_duration;
+    } else if ((strcmp(argv[i], "--io-fraction") == 0) && (i + 1 < argc)) {
+        generator->io_fraction = atof(argv[++i]);
+    } else if ((strcmp(argv[i], "--priorities") == 0) && (i + 1 < argc)) {
+        generator->num_priorities = atoi(argv[++i]);
+    } else if ((strcmp(argv[i], "--sizes") == 0) && (i + 2 < argc)) {
+        generator->min_size = atoi(argv[++i]);
+        generator->max_size = atoi(argv[++i]);
+    } else {
+        return -1;
+    }
 
-        // If I/O frequency for a process is 0, set it to be greater than the CPU burst time so I/O never occurs
-        if (processes[i]->io_frequency == 0) {
-            processes[i]->time_until_io = processes[i]->remaining_cpu_time;
-            if (processes[i]->io_duration == 0) {
-                processes[i]->io_duration == 1;
-            } 
+    // Time distributions are given as a name and a mean
+    if (distribution != NULL) {
+        if (!parse_distribution(argv[i + 1], &distribution->type)) {
+            printf("Unknown distribution %s, use constant, uniform or exponential", argv[i + 1]);
+            exit_on_error();
         }
+        distribution->mean = atof(argv[i + 2]);
+        i += 2;
     }
-    // Exit if there is an error
-    if (exit) {
-        assert(false);
+    return i;
+}
+
+sim_process_t *generate_workload(const sim_generator_t *generator, int num_processes) {
+    /*
+     * Generates a workload, stopping with an error if the generator settings are not valid.
+     */
+
+    sim_process_t *processes = sim_generate(generator, num_processes);
+    if (processes == NULL) {
+        printf("\nERROR >>> Invalid workload generator settings: the mean times must be at least 1 ms, the burst "
+               "size at least 1, the I/O fraction between 0 and 1, and there must be at least one priority and a "
+               "size range from 0 Mb up\n");
+        exit_on_error();
     }
+    return processes;
 }
 
+void write_workload(char file_name[], const sim_process_t processes[], int num_processes, _Bool binary) {
+    /*
+     * Writes a workload as a text input file, or as a binary workload.
+     */
 
+    if (binary) {
+        binary_writer_t *writer = open_binary_writer(file_name, WORKLOAD_MAGIC);
+        for (int i = 0; i < num_processes; i++) {
+            write_workload_record(writer, &processes[i]);
+        }
+        close_binary_writer(writer);
+        return;
+    }
 
-// Main Script
+    FILE *output = open_write_file(file_name);
+    for (int i = 0; i < num_processes; i++) {
+        write_process_line(output, &processes[i]);
+    }
+    fclose(output);
+    output_file = NULL;
+}
 
-int main(int argc, char *argv[]) {
+void write_percentiles(FILE *output, const char *name, const sim_percentiles_t *percentiles) {
+    /*
+     * Displays the percentiles of a time of the processes and writes them to output unless it is NULL.
+     */
 
-    // Asserts the correct number of arguments is passed when running the program from command prompt
-    if ((argc < 6) || (argc > 6)) {
-        printf("Incorrect number of arguments");
-        assert(false);
+    write_metric(output, "%s PERCENTILES >>> p50 %d ms, p90 %d ms, p99 %d ms, p99.9 %d ms, max %d ms\n\n", name,
+                 percentiles->p50, percentiles->p90, percentiles->p99, percentiles->p999, percentiles->max);
+}
+
+void write_metrics(const sim_metrics_t *metrics, const sim_config_t *config, FILE *output) {
+    /*
+     * Displays the metrics of a finished simulation and writes them to its output file.
+     */
+
+    int num_processes = metrics->num_processes;
+    int time_elapsed = metrics->time_elapsed;
+
+    if (output != NULL) {
+        fprintf(output, "\n\nNUMBER OF PROCESSES >>> %d\n\n", num_processes);
     }
 
-    // Manage inputs
-    int scheduler_type = atoi(argv[3]);
-    int quantum;                    // The quantum is hardcoded to be 1000000 for all schedulers except the round robin scheduler
-    if (scheduler_type == 2) {      // This is so that the quantum doesn't interfere in any other process
-        quantum = atoi(argv[4]);    // The quantum can be specified in an input parameter for the round robin scheduler
-    } else {
-        quantum = 1000000;
+    write_metric(output, "THROUGHPUT >>> %.2lf ms/process\n\n", (double) time_elapsed / num_processes);
+
+    write_metric(output, "AVERAGE TURNAROUND TIME >>> %.2lf ms/process\n\n", (double) metrics->total_turnaround_time / num_processes);
+
+    write_metric(output, "TOTAL WAIT TIME >>> %lld ms\n\n", metrics->total_waiting_time);
+
+    write_metric(output, "AVERAGE WAIT TIME >>> %.2lf ms/process\n\n", (double) metrics->total_waiting_time / num_processes);
+
+    write_metric(output, "AVERAGE CPU BURST TIME >>> %.2lf ms/process\n\n", (double) metrics->total_cpu_burst_time / num_processes);
+
+    if (metrics->num_cpus > 1) {
+        for (int core = 0; core < metrics->num_cpus; core++) {
+            write_metric(output, "CPU %d UTILIZATION >>> %.2lf %%\n\n", core, 100.0 * metrics->cpu_busy_time[core] / time_elapsed);
+        }
     }
 
-    _Bool use_memory_management;
-    if (atoi(argv[5]) != 0) {           // Translates input parameter in command prompt to indicate if memory management
-        use_memory_management = true;   // is being used
-    } else {
-        use_memory_management = false;
-    }
-
-    // Allocate an empty queue on the heap for each state in the diagram
-    queue_t *new = new_queue();
-    queue_t *ready = new_queue();
-    queue_t *running = new_queue();
-    queue_t *waiting = new_queue();
-    queue_t *terminated = new_queue();
-
-    // At this point, the memory portion used is one of two as selected by the user
-    // This system was designed so that you only need to modify the following array to change memory for the whole program
-    int memory_portion_sizes[] = {0, 0, 0, 0};
-    if (atoi(argv[5]) == 1) {
-        memory_portion_sizes[0] = 500;
-        memory_portion_sizes[1] = 250;
-        memory_portion_sizes[2] = 150;
-        memory_portion_sizes[3] = 100;
-    } else if (atoi(argv[5]) == 2) {
-        memory_portion_sizes[0] = 300;
-        memory_portion_sizes[1] = 300;
-        memory_portion_sizes[2] = 350;
-        memory_portion_sizes[3] = 50;
-    }
-
-    // Set up actual main_memory 2D array based on memory_portion_sizes array
-    int num_portions = sizeof(memory_portion_sizes) / sizeof(int);
-    int main_memory[num_portions][2];
-    for (int i = 0; i < num_portions; i++) {
-        main_memory[i][0] = memory_portion_sizes[i];
-        main_memory[i][1] = 0;
-    }
-
-    // Remove all previous writing in the output file
-    erase_write_file(argv[2]);
-
-    // Add header to the output file
-    FILE *f5 = fopen(argv[2], "a");
-    assert(f5 != NULL);
-    fprintf(f5, "%-14s %-14s %-14s %-14s\n\n", "Time", "PID", "Old State", "New State");
-    fclose(f5);
-
-    // Variable initialization for metrics
-    int total_cpu_burst_time = 0;
-    int total_turnaround_time = 0;
-    int total_waiting_time = 0;
-    int total_time_between_io = 0;
-    int num_io = 0;
-    
-    // Variable initialization for input file parsing
-    int pid;
-    int arrival_time;
-    int total_cpu_time;
-    int io_freq;
-    int io_dur;
-    int priority;
-    int process_size;
-    int num_processes = 0;
+    if (metrics->paging) {
+        double fault_rate = (metrics->page_references > 0) ? (double) metrics->page_faults / metrics->page_references : 0;
+        double emat = (1 - fault_rate) * config->access_time + fault_rate * config->fault_time * 1e6;
+        write_metric(output, "PAGE FAULTS >>> %lld / %lld references\n\n", metrics->page_faults, metrics->page_references);
+        write_metric(output, "PAGE FAULT RATE >>> %.4lf %%\n\n", 100 * fault_rate);
+        write_metric(output, "EFFECTIVE MEMORY ACCESS TIME >>> %.2lf ns\n\n", emat);
+    }
 
-    // Input file parsing
-    FILE *f3 = fopen(argv[1], "r");
-    assert(f3 != NULL);
-    while (!feof(f3)) {
-        fscanf(f3, "%d %d %d %d %d %d %d\n", &pid, &arrival_time, &total_cpu_time, &io_freq, &io_dur, &priority, &process_size);
-        num_processes++;
+    if (metrics->swapping) {
+        write_metric(output, "SWAP OUTS >>> %d\n\n", metrics->num_swap_outs);
+        write_metric(output, "SWAP INS >>> %d\n\n", metrics->num_swap_ins);
+        write_metric(output, "SWAP TRAFFIC >>> %lld Mb\n\n", metrics->swap_traffic);
     }
 
-    pcb_t *inputted_processes[num_processes];       // Create an array to hold the pcb's of all processes
+    if (metrics->num_io > 0) {
+        write_metric(output, "AVERAGE RESPONSE TIME >>> %.2lf ms", (double) metrics->total_time_between_io / metrics->num_io);
+    }
 
-    rewind(f3);
+    // Tail of the times of each process, the response time here is the time until a process first runs. It is
+    // only printed in the terminal, the output file ends as it always has so that it can be compared as it is.
+    if (metrics->num_terminated > 0) {
+        write_metric(NULL, "\n\n");
+        write_percentiles(NULL, "TURNAROUND TIME", &metrics->turnaround_time);
+        write_percentiles(NULL, "WAIT TIME", &metrics->waiting_time);
+        write_percentiles(NULL, "FIRST RUN TIME", &metrics->response_time);
+        write_percentiles(NULL, "ADMISSION TIME", &metrics->admission_time);
+    }
+    if ((output != NULL) && (metrics->num_io > 0) && (metrics->num_terminated > 0) &&
+        ((metrics->num_deadlines > 0) || (metrics->num_periodic > 0))) {
+        fprintf(output, "\n\n");  // The response time is the only metric not followed by a blank line
+    }
 
-    for (int i = 0; i < num_processes; i++) {
-        fscanf(f3, "%d %d %d %d %d %d %d\n", &pid, &arrival_time, &total_cpu_time, &io_freq, &io_dur, &priority, &process_size);
-        inputted_processes[i] = new_pcb(pid, arrival_time, total_cpu_time, io_freq, io_dur, priority, process_size);
-        total_cpu_burst_time += inputted_processes[i]->remaining_cpu_time;
+    // Deadlines, and the utilization of the periodic processes against the Liu and Layland bounds under which
+    // they always meet their deadlines on one CPU: n(2^(1/n) - 1) with rate monotonic and 100% with EDF
+    if ((metrics->num_terminated > 0) && (metrics->num_deadlines > 0)) {
+        write_metric(output, "DEADLINE MISSES >>> %d / %d processes (%.2lf %%)\n\n", metrics->num_missed_deadlines,
+                     metrics->num_deadlines, 100.0 * metrics->num_missed_deadlines / metrics->num_deadlines);
+        write_percentiles(output, "LATENESS", &metrics->lateness);
     }
-    fclose(f3);
+    if ((metrics->num_terminated > 0) && (metrics->num_periodic > 0)) {
+        long long busy_time = 0;
+        for (int core = 0; core < metrics->num_cpus; core++) {
+            busy_time += metrics->cpu_busy_time[core];
+        }
+        int n = metrics->num_periodic;
+        double utilization = 100 * metrics->periodic_utilization / metrics->num_cpus;
+        double rm_bound = 100 * n * (pow(2.0, 1.0 / n) - 1);
+        write_metric(output, "CPU UTILIZATION >>> %.2lf %%\n\n", 100.0 * busy_time / ((double) time_elapsed * metrics->num_cpus));
+        write_metric(output, "PERIODIC UTILIZATION >>> %.2lf %% per CPU, RM BOUND %.2lf %%, EDF BOUND 100.00 %%\n\n",
+                     utilization, rm_bound);
+        if ((config->scheduler_type == 7) || (config->scheduler_type == 8)) {
+            double bound = (config->scheduler_type == 8) ? rm_bound : 100;
+            write_metric(output, "SCHEDULABILITY TEST >>> %s\n\n", (utilization <= bound) ? "passed" :
+                         "failed, deadlines may be missed");
+        }
+    }
+}
 
-    // Error handling function to check inputs
-    error_handling(inputted_processes, num_processes, memory_portion_sizes, num_portions, use_memory_management);
 
-    // Variable initialization for processing
-    int num_terminated = 0;
-    int wait_until;
-    queue_t *temp = new_queue();
-    pcb_t *curr;
-    pcb_t *prev;
-    int num_filled_memory_portions = 0;
-    _Bool first_loop;
 
-    // Beginning of processing
-    while (num_processes > num_terminated) {
 
-        // Metrics calculations
-        total_waiting_time += ready->size;
-        if (waiting->size == 0) { total_time_between_io++; }
 
-        // Add processes to new at their arrival time
-        int count = 0;
-        for (int i = 0; i < num_processes; i++) {
-            if (inputted_processes[i]->arrival_time == time_elapsed) {
-                enqueue(new, inputted_processes[i]);
-            }
-        }
-        
-        // Move processes from new to ready (admit processes), option to use memory management or not
-        if (use_memory_management) {
-            if (num_filled_memory_portions < num_portions) {
-                curr = new->front;
-                prev = NULL;
-                first_loop = true;
-                while (curr != NULL) {
-                    if (allocate_memory(curr, main_memory, num_portions, argv[2])) {
-                        if (first_loop) {
-                            scheduler(0, scheduler_type, new, ready, argv[2]);
-                            curr = new->front;
-                        } else {
-                            if (curr == new->rear) {
-                                new->rear = prev;
-                            }
-                            prev->next = curr->next;
-                            curr->next = NULL;
-                            new->size--;
-                            enqueue(temp, curr);
-                            scheduler(0, scheduler_type, temp, ready, argv[2]);
-                            curr = prev->next;
-                        }
-                        num_filled_memory_portions++;
-                    } else {
-                        prev = curr;
-                        curr = curr->next;
-                        first_loop = false;
-                    }
-                }
+// Parameter sweep
+
+void run_sweep_worker(sweep_t *sweep) {
+    /*
+     * Runs the simulations of a sweep one after the other, taking the next one that no other worker has taken
+     * until there are none left.
+     */
+
+    int i;
+    while ((i = atomic_fetch_add(&sweep->next_sim, 1)) < sweep->num_sims) {
+        sim_run_until(sweep->sims[i], SIM_FOREVER);
+    }
+}
+
+#ifdef _WIN32
+DWORD WINAPI sweep_thread(LPVOID sweep) {
+    run_sweep_worker(sweep);
+    return 0;
+}
+#else
+void *sweep_thread(void *sweep) {
+    run_sweep_worker(sweep);
+    return NULL;
+}
+#endif
+
+int default_num_threads(void) {
+    /*
+     * Returns the number of processors, which is how many simulations of a sweep run at once by default.
+     */
+
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    return (int) system_info.dwNumberOfProcessors;
+#else
+    long num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return (num_processors > 0) ? (int) num_processors : 1;
+#endif
+}
+
+void run_threads(thread_function_t function, void *context, int num_threads) {
+    /*
+     * Runs function on num_threads threads at once, all given the same context, and waits for all of them to
+     * return.
+     */
+
+#ifdef _WIN32
+    HANDLE *threads = malloc((num_threads > 0 ? num_threads : 1) * sizeof(HANDLE));
+    assert(threads != NULL);
+    for (int i = 0; i < num_threads; i++) {
+        threads[i] = CreateThread(NULL, 0, function, context, 0, NULL);
+        assert(threads[i] != NULL);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+    }
+#else
+    pthread_t *threads = malloc((num_threads > 0 ? num_threads : 1) * sizeof(pthread_t));
+    assert(threads != NULL);
+    for (int i = 0; i < num_threads; i++) {
+        int result = pthread_create(&threads[i], NULL, function, context);
+        assert(result == 0);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+#endif
+    free(threads);
+}
+
+void run_sweep(char input_file[], char sweep_file[], char results_file[], int num_threads) {
+    /*
+     * Parses the workload in input_file once, then simulates it under every setting of sweep_file on a pool of
+     * num_threads threads. Each line of sweep_file holds the arguments that follow the input and output files on
+     * the command line, for example "2 100 0 --event". One row of metrics is written to results_file for each
+     * line, in the order of the lines. If input_file is a snapshot, every line resumes it under its own settings
+     * instead, forking the sweep off the point the snapshot was saved at.
+     */
+
+    input_t *input = open_input(input_file);
+    int num_processes = 0;
+    sim_process_t *processes = NULL;
+    _Bool snapshot = (input->format == SNAPSHOT_FORMAT);
+    if (!snapshot) {
+        processes = read_workload(input, &num_processes);
+    }
+    close_input(input);
+
+    FILE *file = fopen(sweep_file, "r");
+    if (file == NULL) {
+        printf("File was not opened");
+        exit_on_error();
+    }
+
+    // Set up a simulation for each line, the split up arguments are kept since the settings point into them
+    sweep_t sweep;
+    int capacity = 16;
+    char **lines = malloc(capacity * sizeof(char *));
+    char **arguments = malloc(capacity * sizeof(char *));
+    sweep.sims = malloc(capacity * sizeof(sim_t *));
+    assert((lines != NULL) && (arguments != NULL) && (sweep.sims != NULL));
+    sweep.num_sims = 0;
+    char line[4096];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (strspn(line, " \t") == strlen(line)) {
+            continue;
+        }
+        if (sweep.num_sims == capacity) {
+            capacity *= 2;
+            lines = realloc(lines, capacity * sizeof(char *));
+            arguments = realloc(arguments, capacity * sizeof(char *));
+            sweep.sims = realloc(sweep.sims, capacity * sizeof(sim_t *));
+            assert((lines != NULL) && (arguments != NULL) && (sweep.sims != NULL));
+        }
+
+        lines[sweep.num_sims] = malloc(strlen(line) + 1);
+        arguments[sweep.num_sims] = malloc(strlen(line) + 1);
+        assert((lines[sweep.num_sims] != NULL) && (arguments[sweep.num_sims] != NULL));
+        strcpy(lines[sweep.num_sims], line);
+        strcpy(arguments[sweep.num_sims], line);
+
+        char *argv[64];
+        int argc = 0;
+        char *token = strtok(arguments[sweep.num_sims], " \t");
+        while ((token != NULL) && (argc < 64)) {
+            argv[argc++] = token;
+            token = strtok(NULL, " \t");
+        }
+        options_t options;
+        parse_options(&options, argc, argv);
+        if (options.stream || options.binary || (options.process_log != NULL) || (options.samples != NULL) ||
+            (options.num_checkpoints > 0)) {
+            printf("\nERROR >>> Line %d of %s: a sweep writes no output file and parses the input once, so it "
+                   "cannot use --stream, --binary, --process-log, --samples or --checkpoint\n", sweep.num_sims + 1,
+                   sweep_file);
+            exit_on_error();
+        }
+
+        // Every simulation of a sweep over a snapshot is a branch resumed from the same point
+        sim_t *sim;
+        if (snapshot) {
+            sim = restore_snapshot(input_file, &options.config);
+        } else {
+            sim = sim_create(&options.config);
+            if (sim == NULL) {
+                exit_on_error();
             }
-        } else {       // This else statement is used if memory management is not to be used
-            while (new->size != 0) {
-                scheduler(0, scheduler_type, new, ready, argv[2]);
+            if (!sim_load(sim, processes, num_processes)) {
+                exit_on_error();
             }
         }
+        sweep.sims[sweep.num_sims++] = sim;
+    }
+    fclose(file);
+
+    // Run the simulations on the thread pool
+    atomic_init(&sweep.next_sim, 0);
+    run_threads(sweep_thread, &sweep, (num_threads < sweep.num_sims) ? num_threads : sweep.num_sims);
+
+    // Write one row of metrics for each simulation
+    FILE *results = open_write_file(results_file);
+    fprintf(results, "configuration,processes,end_time,throughput,average_turnaround_time,total_wait_time,"
+                     "average_wait_time,average_cpu_burst_time,average_response_time,page_faults,page_references\n");
+    for (int i = 0; i < sweep.num_sims; i++) {
+        sim_metrics_t metrics = sim_metrics(sweep.sims[i]);
+        int n = (metrics.num_processes > 0) ? metrics.num_processes : 1;
+        fprintf(results, "\"%s\",%d,%d,%.2lf,%.2lf,%lld,%.2lf,%.2lf,%.2lf,%lld,%lld\n", lines[i], metrics.num_processes,
+                metrics.time_elapsed, (double) metrics.time_elapsed / n, (double) metrics.total_turnaround_time / n,
+                metrics.total_waiting_time, (double) metrics.total_waiting_time / n,
+                (double) metrics.total_cpu_burst_time / n,
+                (metrics.num_io > 0) ? (double) metrics.total_time_between_io / metrics.num_io : 0.0,
+                metrics.page_faults, metrics.page_references);
+        sim_destroy(sweep.sims[i]);
+        free(lines[i]);
+        free(arguments[i]);
+    }
+    fclose(results);
+    output_file = NULL;
+
+    free(lines);
+    free(arguments);
+    free(sweep.sims);
+    free(processes);
+}
+
+
+
+// Monte Carlo runs
+
+const char *monte_carlo_metric_names[NUM_MONTE_CARLO_METRICS] = {
+    "end_time", "throughput", "average_turnaround_time", "average_wait_time", "p99_turnaround_time",
+    "p99_response_time", "cpu_utilization", "page_faults", "missed_deadlines"
+};
+
+void record_replica(monte_carlo_t *monte_carlo, int replica, const sim_metrics_t *metrics) {
+    /*
+     * Stores the metrics of a finished replica in its row of the metric columns. Each replica has its own row,
+     * so the threads never write to the same value.
+     */
+
+    int n = (metrics->num_processes > 0) ? metrics->num_processes : 1;
+    long long busy_time = 0;
+    for (int i = 0; i < metrics->num_cpus; i++) {
+        busy_time += metrics->cpu_busy_time[i];
+    }
+    long long capacity = (long long) metrics->time_elapsed * metrics->num_cpus;
+
+    double **values = monte_carlo->values;
+    values[END_TIME_METRIC][replica] = metrics->time_elapsed;
+    values[THROUGHPUT_METRIC][replica] = (double) metrics->time_elapsed / n;
+    values[TURNAROUND_METRIC][replica] = (double) metrics->total_turnaround_time / n;
+    values[WAIT_METRIC][replica] = (double) metrics->total_waiting_time / n;
+    values[P99_TURNAROUND_METRIC][replica] = metrics->turnaround_time.p99;
+    values[P99_RESPONSE_METRIC][replica] = metrics->response_time.p99;
+    values[CPU_UTILIZATION_METRIC][replica] = (capacity > 0) ? 100.0 * busy_time / capacity : 0;
+    values[PAGE_FAULTS_METRIC][replica] = (double) metrics->page_faults;
+    values[MISSED_DEADLINES_METRIC][replica] = metrics->num_missed_deadlines;
+}
+
+void run_monte_carlo_worker(monte_carlo_t *monte_carlo) {
+    /*
+     * Runs the replicas of a Monte Carlo run one after the other, taking the next one that no other worker has
+     * taken until there are none left. Each replica is perturbed into the same array, which is only needed
+     * until its simulation is destroyed.
+     */
+
+    int num_processes = monte_carlo->num_processes;
+    sim_process_t *processes = malloc((num_processes > 0 ? num_processes : 1) * sizeof(sim_process_t));
+    assert(processes != NULL);
+
+    int i;
+    while ((i = atomic_fetch_add(&monte_carlo->next_replica, 1)) < monte_carlo->num_replicas) {
+        memcpy(processes, monte_carlo->processes, num_processes * sizeof(sim_process_t));
+        sim_perturb(processes, num_processes, monte_carlo->spread, monte_carlo->seed + (unsigned int) i);
+        sim_t *sim = sim_create(monte_carlo->config);
+        if (sim == NULL) {
+            exit_on_error();
+        }
+        if (!sim_load(sim, processes, num_processes)) {
+            exit_on_error();
+        }
+        sim_run_until(sim, SIM_FOREVER);
+        sim_metrics_t metrics = sim_metrics(sim);
+        record_replica(monte_carlo, i, &metrics);
+        sim_destroy(sim);
+    }
+    free(processes);
+}
+
+#ifdef _WIN32
+DWORD WINAPI monte_carlo_thread(LPVOID monte_carlo) {
+    run_monte_carlo_worker(monte_carlo);
+    return 0;
+}
+#else
+void *monte_carlo_thread(void *monte_carlo) {
+    run_monte_carlo_worker(monte_carlo);
+    return NULL;
+}
+#endif
+
+double t_critical_value(int degrees_of_freedom) {
+    /*
+     * Returns the value that the Student t distribution with the given degrees of freedom exceeds in absolute
+     * value with probability 0.05, which sets the width of a 95% confidence interval. Past the table, the
+     * Cornish-Fisher expansion around the normal value is accurate to well under 0.001.
+     */
+
+    static const double table[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (degrees_of_freedom <= 30) {
+        return table[degrees_of_freedom - 1];
+    }
+    double z = 1.959964;
+    double v = degrees_of_freedom;
+    return z + (z * z * z + z) / (4 * v) + (5 * pow(z, 5) + 16 * z * z * z + 3 * z) / (96 * v * v);
+}
+
+int compare_values(const void *a, const void *b) {
+    /*
+     * Orders the values of a metric column from smallest to largest.
+     */
+
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+double column_percentile(const double sorted[], int n, double fraction) {
+    /*
+     * Returns the value below which the given fraction of a sorted column lies, by the nearest rank.
+     */
+
+    int rank = (int) ceil(fraction * n);
+    return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+void run_monte_carlo(char input_file[], char results_file[], const sim_config_t *config, int num_replicas,
+                     double spread, unsigned int seed, int num_threads) {
+    /*
+     * Simulates num_replicas replicas of the workload in input_file under config on a pool of num_threads
+     * threads. Each replica scales the CPU time and the I/O duration of every process by its own random factor
+     * from 1 - spread to 1 + spread. The metrics of the replicas are kept as one column per metric, and
+     * results_file gets one row per metric with its mean, standard deviation, 95% confidence interval of the
+     * mean, and the spread of its values over the replicas. The same seed always gives the same results,
+     * whatever the number of threads.
+     */
 
-        // If there is a process in ready and running is empty, transition
-        if ((ready->size > 0) && (running->size == 0)) {
-            transition(1, ready, running, argv[2]);
-            running->front->cpu_arrival_time = time_elapsed;
+    input_t *input = open_input(input_file);
+    if (input->format == SNAPSHOT_FORMAT) {
+        printf("\nERROR >>> %s is a snapshot, a Monte Carlo run needs a workload to perturb\n", input_file);
+        exit_on_error();
+    }
+    int num_processes;
+    sim_process_t *processes = read_workload(input, &num_processes);
+    close_input(input);
+
+    // Check the workload against the settings once, so that a replica cannot fail on a thread
+    sim_t *sim = sim_create(config);
+    if (sim == NULL) {
+        exit_on_error();
+    }
+    if (!sim_load(sim, processes, num_processes)) {
+        exit_on_error();
+    }
+    sim_destroy(sim);
+
+    monte_carlo_t monte_carlo;
+    monte_carlo.processes = processes;
+    monte_carlo.num_processes = num_processes;
+    monte_carlo.config = config;
+    monte_carlo.spread = spread;
+    monte_carlo.seed = seed;
+    monte_carlo.num_replicas = num_replicas;
+    atomic_init(&monte_carlo.next_replica, 0);
+    for (int m = 0; m < NUM_MONTE_CARLO_METRICS; m++) {
+        monte_carlo.values[m] = malloc(num_replicas * sizeof(double));
+        assert(monte_carlo.values[m] != NULL);
+    }
+    run_threads(monte_carlo_thread, &monte_carlo, (num_threads < num_replicas) ? num_threads : num_replicas);
+
+    // Summarize each column, the mean and the deviation first since sorting it for the percentiles reorders it
+    FILE *results = open_write_file(results_file);
+    fprintf(results, "metric,replicas,mean,std_dev,ci95_low,ci95_high,min,p5,p50,p95,max\n");
+    printf("%-24s %-12s %-12s %-27s %-12s %-12s\n", "Metric", "Mean", "Std dev", "95% CI of the mean", "p5", "p95");
+    for (int m = 0; m < NUM_MONTE_CARLO_METRICS; m++) {
+        double *column = monte_carlo.values[m];
+        double sum = 0;
+        for (int i = 0; i < num_replicas; i++) {
+            sum += column[i];
+        }
+        double mean = sum / num_replicas;
+        double squares = 0;
+        for (int i = 0; i < num_replicas; i++) {
+            squares += (column[i] - mean) * (column[i] - mean);
+        }
+        double deviation = (num_replicas > 1) ? sqrt(squares / (num_replicas - 1)) : 0;
+        double half_width = 0;
+        if (num_replicas > 1) {
+            half_width = t_critical_value(num_replicas - 1) * deviation / sqrt(num_replicas);
         }
 
-        // If there is a process in running, check if it needs to transition and update its
-        // remaining CPU time.
-        if (running->size > 0) {
+        qsort(column, num_replicas, sizeof(double), compare_values);
+        double p5 = column_percentile(column, num_replicas, 0.05);
+        double p50 = column_percentile(column, num_replicas, 0.5);
+        double p95 = column_percentile(column, num_replicas, 0.95);
+        fprintf(results, "%s,%d,%.4lf,%.4lf,%.4lf,%.4lf,%.4lf,%.4lf,%.4lf,%.4lf,%.4lf\n", monte_carlo_metric_names[m],
+                num_replicas, mean, deviation, mean - half_width, mean + half_width, column[0], p5, p50, p95,
+                column[num_replicas - 1]);
+        char interval[64];
+        snprintf(interval, sizeof(interval), "%.2lf - %.2lf", mean - half_width, mean + half_width);
+        printf("%-24s %-12.2lf %-12.2lf %-27s %-12.2lf %-12.2lf\n", monte_carlo_metric_names[m], mean, deviation,
+               interval, p5, p95);
+        free(column);
+    }
+    fclose(results);
+    output_file = NULL;
+    free(processes);
+}
+
+
+
+// Benchmarks
+
+double wall_time(void) {
+    /*
+     * Returns a time in seconds from a clock that only ever moves forward, for timing simulations.
+     */
+
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double) counter.QuadPart / frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+#endif
+}
+
+long long peak_rss_kb(void) {
+    /*
+     * Returns the most memory the program has held in RAM so far, in Kb.
+     */
 
-            // If the process in running is done executing, move it from running to terminated
-            if (running->front->remaining_cpu_time == 0) {
-                total_turnaround_time += time_elapsed - running->front->arrival_time;
-                transition(5, running, terminated, argv[2]);
-                if (use_memory_management) {
-                    deallocate_memory(terminated->front, main_memory, num_portions);
-                    num_filled_memory_portions--;
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return (long long) counters.PeakWorkingSetSize / 1024;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;      // In bytes on macOS, in Kb everywhere else
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+void run_benchmark(char results_file[], const sim_generator_t *generator, int max_processes, double time_limit) {
+    /*
+     * Times the simulator on generated workloads of 1000 processes, then 10 times more up to max_processes.
+     * Each workload is run under every scheduler and memory management mode, event-driven and with no limit on
+     * the I/O devices, and one row is written to results_file for each run as soon as it finishes. The time
+     * covers loading the workload into the simulation and running it, but not generating it. The transitions
+     * are counted as the events of the simulation. The peak RSS is that of the whole benchmark so far, which
+     * is set by the biggest workload since the workloads grow. A scheduler and memory management mode stops
+     * at the workload where its next one, 10 times bigger, would take more than time_limit seconds, which is
+     * at least 10 times as long.
+     */
+
+    _Bool too_slow[NUM_SCHEDULERS][NUM_MEMORY_MODES] = {{false}};
+
+    FILE *results = open_write_file(results_file);
+    fprintf(results, "scheduler,memory_mode,processes,transitions,end_time,seconds,events_per_second,"
+                     "ns_per_transition,peak_rss_kb\n");
+    printf("%-10s %-12s %-12s %-14s %-12s %-16s %-18s %-12s\n", "Scheduler", "Memory mode", "Processes",
+           "Transitions", "Seconds", "Events/second", "ns/transition", "Peak RSS Kb");
+
+    for (long long num_processes = 1000; num_processes <= max_processes; num_processes *= 10) {
+        sim_process_t *processes = generate_workload(generator, (int) num_processes);
+        for (int scheduler_type = 0; scheduler_type < NUM_SCHEDULERS; scheduler_type++) {
+            for (int memory_mode = 0; memory_mode < NUM_MEMORY_MODES; memory_mode++) {
+                if (too_slow[scheduler_type][memory_mode]) {
+                    continue;
                 }
-                dequeue(terminated, true);
-                num_terminated++;
-            
-            // If the process in running needs I/O, transition from running to waiting
-            } else if (running->front->time_until_io == 0) {
-                num_io++;
-                running->front->time_until_io = running->front->io_frequency;
-                transition(2, running, waiting, argv[2]);
-                if (waiting->size == 1) {
-                    wait_until = time_elapsed + waiting->front->io_duration;
+                sim_config_t config;
+                sim_default_config(&config);
+                config.scheduler_type = scheduler_type;
+                config.memory_mode = memory_mode;
+                config.event_driven = true;
+                config.io_devices = 0;      // Page faults would otherwise keep a single device busy for good
+
+                double start = wall_time();
+                sim_t *sim = sim_create(&config);
+                if (sim == NULL) {
+                    exit_on_error();
                 }
-            
-            // If an interrupt is triggered because a process has been in running for too long,
-			// transition to ready.
-            } else if ((time_elapsed - running->front->cpu_arrival_time) > quantum)  {
-                scheduler(4, scheduler_type, running, ready, argv[2]);
-            } else {
-                running->front->remaining_cpu_time -= 1;
-                running->front->time_until_io -= 1;
+                if (!sim_load(sim, processes, (int) num_processes)) {
+                    exit_on_error();
+                }
+                sim_run_until(sim, SIM_FOREVER);
+                double seconds = wall_time() - start;
+                sim_metrics_t metrics = sim_metrics(sim);
+                sim_destroy(sim);
+                too_slow[scheduler_type][memory_mode] = (10 * seconds > time_limit);
+
+                double events_per_second = (seconds > 0) ? metrics.num_transitions / seconds : 0;
+                double ns_per_transition = (metrics.num_transitions > 0) ? 1e9 * seconds / metrics.num_transitions : 0;
+                long long peak_rss = peak_rss_kb();
+                fprintf(results, "%d,%d,%lld,%lld,%d,%.6lf,%.0lf,%.2lf,%lld\n", scheduler_type, memory_mode,
+                        num_processes, metrics.num_transitions, metrics.time_elapsed, seconds, events_per_second,
+                        ns_per_transition, peak_rss);
+                fflush(results);
+                printf("%-10d %-12d %-12lld %-14lld %-12.3lf %-16.0lf %-18.2lf %-12lld\n", scheduler_type, memory_mode,
+                       num_processes, metrics.num_transitions, seconds, events_per_second, ns_per_transition, peak_rss);
+                fflush(stdout);
             }
         }
+        free(processes);
+    }
+    fclose(results);
+    output_file = NULL;
+}
 
-        // If there is a process in waiting and it is done, transition to ready and 
-		// set wait_until for the new process.
-        if ((time_elapsed == wait_until) && (waiting->size > 0)) {
-            scheduler(3, scheduler_type, waiting, ready, argv[2]);
-            if (waiting->size > 0) {
-                wait_until = time_elapsed + waiting->front->io_duration;
-            }
-        }
-        time_elapsed++;
+
+
+// Main Script
+
+int main(int argc, char *argv[]) {
+
+    // Converting a file between its text and binary format does not run a simulation
+    if ((argc == 4) && (strcmp(argv[1], "--convert") == 0)) {
+        convert_file(argv[2], argv[3]);
+        return 0;
     }
 
-    // Free queues, no need to free pcb's because they have already been deallocated by dequeue
-    free(new);
-    free(ready);
-    free(running);
-    free(waiting);
-    free(terminated);
-    free(temp);
+    // A sweep runs many simulations of one input file, given as input file, sweep file and results file
+    if ((argc >= 5) && (strcmp(argv[1], "--sweep") == 0)) {
+        int num_threads = default_num_threads();
+        if ((argc == 7) && (strcmp(argv[5], "--threads") == 0)) {
+            num_threads = atoi(argv[6]);
+        } else if (argc != 5) {
+            printf("Incorrect number of arguments");
+            exit_on_error();
+        }
+        if (num_threads < 1) {
+            printf("There must be at least one thread");
+            exit_on_error();
+        }
+        run_sweep(argv[2], argv[3], argv[4], num_threads);
+        return 0;
+    }
 
-    // Display metrics and write them to the output file
-    FILE *f4 = fopen(argv[2], "a");
-    assert(f4 != NULL);
+    // A Monte Carlo run simulates perturbed replicas of a workload, given as input file, results file and number
+    // of replicas, followed by its own options and then the settings the replicas run under
+    if ((argc >= 5) && (strcmp(argv[1], "--monte-carlo") == 0)) {
+        int num_replicas = atoi(argv[4]);
+        double spread = 0.1;
+        unsigned int seed = 1;
+        int num_threads = default_num_threads();
+        int i = 5;
+        for (; i + 1 < argc; i += 2) {
+            if (strcmp(argv[i], "--spread") == 0) {
+                spread = atof(argv[i + 1]);
+            } else if (strcmp(argv[i], "--seed") == 0) {
+                seed = (unsigned int) strtoul(argv[i + 1], NULL, 10);
+            } else if (strcmp(argv[i], "--threads") == 0) {
+                num_threads = atoi(argv[i + 1]);
+            } else {
+                break;
+            }
+        }
+        if (num_replicas < 1) {
+            printf("There must be at least one replica");
+            exit_on_error();
+        }
+        if (!(spread >= 0) || !(spread < 1)) {
+            printf("The spread must be at least 0 and less than 1");
+            exit_on_error();
+        }
+        if (num_threads < 1) {
+            printf("There must be at least one thread");
+            exit_on_error();
+        }
+        options_t options;
+        parse_options(&options, argc - i, argv + i);
+        if (options.stream || options.binary || (options.process_log != NULL) || (options.samples != NULL) ||
+            (options.num_checkpoints > 0)) {
+            printf("A Monte Carlo run writes no output file and parses the input once, so it cannot use --stream, "
+                   "--binary, --process-log, --samples or --checkpoint");
+            exit_on_error();
+        }
+        run_monte_carlo(argv[2], argv[3], &options.config, num_replicas, spread, seed, num_threads);
+        return 0;
+    }
 
-    fprintf(f4, "\n\nNUMBER OF PROCESSES >>> %d\n\n", num_processes);
+    // Generating a workload writes it to a file, given as output file and number of processes
+    if ((argc >= 4) && (strcmp(argv[1], "--generate") == 0)) {
+        sim_generator_t generator;
+        sim_default_generator(&generator);
+        _Bool binary = false;
+        for (int i = 4; i < argc; i++) {
+            if (strcmp(argv[i], "--binary") == 0) {
+                binary = true;
+            } else {
+                int last_argument = parse_generator_option(&generator, argc, argv, i);
+                if (last_argument == -1) {
+                    printf("Unknown option %s", argv[i]);
+                    exit_on_error();
+                }
+                i = last_argument;
+            }
+        }
+        int num_processes = atoi(argv[3]);
+        sim_process_t *processes = generate_workload(&generator, num_processes);
+        write_workload(argv[2], processes, num_processes, binary);
+        free(processes);
+        return 0;
+    }
 
-    fprintf(f4, "THROUGHPUT >>> %.2lf ms/process\n\n", (double) time_elapsed / num_processes);
-    printf("THROUGHPUT >>> %.2lf ms/process\n\n", (double) time_elapsed / num_processes);
+    // A benchmark times simulations of generated workloads, given as results file
+    if ((argc >= 3) && (strcmp(argv[1], "--benchmark") == 0)) {
+        sim_generator_t generator;
+        sim_default_generator(&generator);
+        int max_processes = 10000000;
+        double time_limit = 60;
+        for (int i = 3; i < argc; i++) {
+            if ((strcmp(argv[i], "--max-processes") == 0) && (i + 1 < argc)) {
+                max_processes = atoi(argv[++i]);
+            } else if ((strcmp(argv[i], "--time-limit") == 0) && (i + 1 < argc)) {
+                time_limit = atof(argv[++i]);
+            } else {
+                int last_argument = parse_generator_option(&generator, argc, argv, i);
+                if (last_argument == -1) {
+                    printf("Unknown option %s", argv[i]);
+                    exit_on_error();
+                }
+                i = last_argument;
+            }
+        }
+        run_benchmark(argv[2], &generator, max_processes, time_limit);
+        return 0;
+    }
 
-    fprintf(f4, "AVERAGE TURNAROUND TIME >>> %.2lf ms/process\n\n", (double) total_turnaround_time / num_processes);
-    printf("AVERAGE TURNAROUND TIME >>> %.2lf ms/process\n\n", (double) total_turnaround_time / num_processes);
+    // Asserts the correct number of arguments is passed when running the program from command prompt
+    if (argc < 6) {
+        printf("Incorrect number of arguments");
+        exit_on_error();
+    }
+    options_t options;
+    parse_options(&options, argc - 3, argv + 3);
+
+    // Open the output file, removing all previous writing in it. A binary transition log takes the place of the
+    // output file, and the metrics are then only printed in the terminal.
+    FILE *output = NULL;
+    if (options.binary) {
+        transition_log = open_binary_writer(argv[2], LOG_MAGIC);
+        } else {
+        output = open_write_file(argv[2]);
 
-    fprintf(f4, "TOTAL WAIT TIME >>> %d ms\n\n", total_waiting_time);
-    printf("TOTAL WAIT TIME >>> %d ms\n\n", total_waiting_time);
+        // Add header to the output file
+        fprintf(output, "%-14s %-14s %-14s %-14s\n\n", "Time", "PID", "Old State", "New State");
+    }
 
-    fprintf(f4, "AVERAGE WAIT TIME >>> %.2lf ms/process\n\n", (double) total_waiting_time / num_processes);
-    printf("AVERAGE WAIT TIME >>> %.2lf ms/process\n\n", (double) total_waiting_time / num_processes);
+    // Input file parsing, in one pass straight from the mapped file, unless each process is read just before it
+    // arrives. A snapshot holds the processes itself, and the simulation resumes from it under the settings given.
+    input_t *input = open_input(argv[1]);
+    sim_process_t *processes = NULL;
+    sim_t *sim;
+    if (input->format == SNAPSHOT_FORMAT) {
+        if (options.stream) {
+            printf("A snapshot cannot be streamed, it is resumed from as a whole");
+            exit_on_error();
+        }
+        close_input(input);
+        input = NULL;
+        sim = restore_snapshot(argv[1], &options.config);
+    } else if (options.stream) {
+        sim = sim_create(&options.config);
+        if (sim == NULL) {
+            exit_on_error();
+        }
+        sim_stream(sim, read_streamed_process, input);
+    } else {
+        sim = sim_create(&options.config);
+        if (sim == NULL) {
+            exit_on_error();
+        }
+        int num_processes;
+        processes = read_workload(input, &num_processes);
+        close_input(input);
+        input = NULL;
+        if (!sim_load(sim, processes, num_processes)) {
+            exit_on_error();
+        }
+    }
 
-    fprintf(f4, "AVERAGE CPU BURST TIME >>> %.2lf ms/process\n\n", (double) total_cpu_burst_time / num_processes);
-    printf("AVERAGE CPU BURST TIME >>> %.2lf ms/process\n\n", (double) total_cpu_burst_time / num_processes);
+    // Run the simulation
+    if (options.binary) {
+        sim_set_transition_callback(sim, log_transition, transition_log);
+    } else {
+        sim_set_output(sim, output);
+    }
+    FILE *process_log = NULL;
+    if (options.process_log != NULL) {
+        process_log = fopen(options.process_log, "w");
+        if (process_log == NULL) {
+            printf("\nERROR >>> Could not open the process log %s\n", options.process_log);
+            exit_on_error();
+        }
+        sim_set_process_log(sim, process_log);
+    }
+    binary_writer_t *samples = NULL;
+    if (options.samples != NULL) {
+        samples = open_binary_writer(options.samples, SAMPLES_MAGIC);
+        unsigned char header[8];
+        put_le32(header, (unsigned int) options.config.sample_interval);
+        put_le32(header + 4, SAMPLE_COLUMNS);
+        write_bytes(samples, header, sizeof(header));
+        sim_set_sample_callback(sim, log_samples, samples);
+    }
+    for (int i = 0; i < options.num_checkpoints; i++) {
+        sim_run_until(sim, options.checkpoint_times[i]);
+        save_checkpoint(sim, options.checkpoint_files[i]);
+    }
+    if (!sim_run_until(sim, SIM_FOREVER)) {
+        exit_on_error();    // An invalid process was streamed, the library has printed why
+    }
+    if (samples != NULL) {
+        sim_flush_samples(sim);
+        close_binary_writer(samples);
+    }
 
-    if (num_io > 0) {
-        fprintf(f4, "AVERAGE RESPONSE TIME >>> %.2lf ms", (double) total_time_between_io / num_io);
-        printf("AVERAGE RESPONSE TIME >>> %.2lf ms", (double) total_time_between_io / num_io);
+    // Display metrics and write them to the output file
+    sim_metrics_t metrics = sim_metrics(sim);
+    write_metrics(&metrics, &options.config, output);
+    sim_destroy(sim);
+    if (input != NULL) {
+        close_input(input);
+    }
+    free(processes);
+    if (process_log != NULL) {
+        fclose(process_log);
     }
 
-    fclose(f4);
+    if (options.binary) {
+        close_binary_writer(transition_log);
+        transition_log = NULL;
+    } else {
+        fclose(output);     // Flushes everything left in the output buffer
+        output_file = NULL;
+    }
 
     // DONE!
     return 0;
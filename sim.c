@@ -0,0 +1,4768 @@
+/** Kernel Simulator - Assignment 2, Part II
+ *
+ * Carleton University
+ * Department of System and Computer Engineering
+ * SYSC 4001 - Operating Systems
+ * 
+ * @authors			Trong Nguyen, 100848232
+ * 				Evan Smedley, 101148695
+ * @version			1.0
+ * @release			March 5, 2021
+ *
+ * The simulator library: the queues, schedulers, CPU cores, I/O devices and memory managers of the simulated
+ * kernel, and the simulations that run them. The interface is described in sim.h.
+ */
+
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include "sim.h"
+
+
+
+// Structure implementation
+typedef struct pcb {		// Defines the process control block struct
+    int pid;
+    int arrival_time;
+    int remaining_cpu_time;
+    int cpu_arrival_time;
+    int io_frequency;
+    int io_duration;
+    int time_until_io;
+    int priority;
+    int size_of_process;
+    int base_memory_location;
+    int io_completion_time; // Time at which the I/O the process is being served for completes
+    int io_service_time;    // How long the I/O the process is waiting for takes, its I/O duration or a page fault
+    int next;               // Index in the pcb pool of the next pcb in the queue, -1 if there is none
+    int queue_position;     // Position of the pcb in a sized queue
+    int level;              // MLFQ level, 0 is the top level
+    int weight;             // CFS share of the CPU, from the priority
+    long long vruntime;     // CFS virtual runtime in weighted microseconds
+    int charged_cpu_time;   // Remaining CPU time when the virtual runtime was last charged
+    double predicted_burst; // SJF exponential average of the CPU bursts between I/O
+    int burst_start_cpu_time;   // Remaining CPU time when the current CPU burst started
+    int expected_burst;     // Expected rest of the current CPU burst when the process last became ready
+    // Per-process times, in ms
+    int state_entered_time; // Time of the last transition of the process
+    int admission_time;     // Time the process was admitted, -1 until then
+    int first_run_time;     // Time the process was first dispatched, -1 until then
+    int waiting_time;       // Time spent in the ready queue
+    // Real-time scheduling
+    long long deadline;     // Absolute deadline, LLONG_MAX if the process has none
+    long long period;       // LLONG_MAX if the process is not periodic
+    // Swapping
+    _Bool swapped_out;      // The memory of the process is in the backing store
+    int swap_out_done;      // Time the copy of its memory in the backing store is complete
+    // Paging
+    int *page_table;        // Page node of each page, -1 if the page is neither in a frame nor remembered by ARC
+    int num_pages;
+    int next_page;          // Page of the next memory reference
+    _Bool page_read_in;     // The page of the last page fault has been read in, so the reference that faulted goes ahead
+    int locality_base;      // First page of the pages the process is currently referencing
+    unsigned int reference_state;
+    int trace_start;        // References of the process in the page trace
+    int trace_length;
+    int trace_position;
+} pcb_t;
+
+typedef struct {            // Defines the pool that every pcb is allocated from
+    pcb_t *pcbs;            // One contiguous block holding all of the pcbs
+    int capacity;
+    int size;               // Number of pcbs that have been handed out from the block
+    int free_list;          // Index of the first pcb that was given back to the pool, -1 if there is none
+} pcb_pool_t;
+
+typedef struct {            // Defines an element of an ordered queue's binary heap
+    int pcb;
+    long long key;
+    unsigned long long sequence;
+} heap_entry_t;
+
+typedef struct {      		// Defines the queue struct that will contain pcbs
+    pcb_pool_t *pool;                   // Pool that the indices in the queue refer to
+    int front;                          // Index of the front pcb in the pool, -1 if the queue is empty
+    int rear;
+    int size;
+    long long (*key)(pcb_t *);          // NULL for FIFO queues, otherwise the key the queue is ordered by
+    heap_entry_t *heap;                 // Binary heap holding the pcbs of an ordered queue
+    int capacity;
+    unsigned long long next_sequence;   // Insertion counter that keeps equal keys in FIFO order
+    int num_levels;                     // 0 unless the queue is a multilevel queue, which is a FIFO queue per level
+    int *level_front;
+    int *level_rear;
+    unsigned int level_bitmap;          // Bit l is set if level l is not empty
+    long long total_weight;             // Sum of the CFS weights of the pcbs in the queue
+    int *size_tree;                     // NULL unless the queue is a sized queue, otherwise the smallest process
+                                        // size below each node of a tournament tree over the queue positions
+    int *position_pcb;                  // Pcb at each position of a sized queue, -1 for a removed one
+} queue_t;
+
+typedef struct {            // Defines a blocked process that holds memory, a node of the tree of swap candidates
+    int size;               // Size of the process, the tree is ordered by size, then by pool index
+    _Bool in_tree;
+    unsigned int priority;  // Random treap priority, a parent always has a higher priority than its children
+    long long rank;         // LLONG_MAX in the I/O backlog, otherwise the time its I/O completes
+    unsigned long long sequence;    // When it became a candidate, the later of two equal ranks stays blocked longer
+    int left;               // Children, by pool index, -1 if none
+    int right;
+    int best;               // Candidate of the subtree that stays blocked the longest
+} swap_candidate_t;
+
+typedef struct {            // Defines a free hole of a dynamically partitioned memory
+    int address;
+    int size;
+    unsigned int priority;  // Random treap priority, a parent always has a higher priority than its children
+    int left[2];            // Children in the address ordered tree [0] and in the size ordered tree [1], -1 if none
+    int right[2];
+    int max_size;           // Size of the largest hole in the subtree of the address ordered tree
+} hole_t;
+typedef struct {            // Defines a page that is in a frame, or that ARC remembers after evicting it
+    int *page_table;        // Page table of the process the page belongs to
+    int page;
+    int frame;              // -1 for a page that is only remembered
+    int list;               // Replacement list the page is on
+    int prev;
+    int next;
+    _Bool referenced;       // Reference bit of the clock policy
+} page_node_t;
+
+typedef struct {            // Defines one line of a page trace
+    int pid;
+    int page;
+    int order;              // Line of the reference, keeps the references of each process in order when sorting
+} page_reference_t;
+
+enum { FIXED_PARTITIONS, DYNAMIC_PARTITIONS, BUDDY_SYSTEM, PAGING };  // Memory modes
+enum { ARC_T1, ARC_T2, ARC_B1, ARC_B2 };    // ARC's lists, FIFO, LRU and clock only use the first one
+enum { LOCALITY_PAGES = 4, LOCALITY_REFERENCES = 100 };    // Locality size and mean references before it moves
+typedef struct {            // Defines the main memory that processes are admitted into
+    int mode;
+    int total_size;
+    int num_allocated;      // Number of processes holding memory
+    // Fixed partitions
+    int num_portions;
+    int (*portions)[2];     // Size of each portion and the size of the process in it, 0 if the portion is free
+    int num_used_portions;  // used_memory and free_memory are kept as for the buddy system, free_memory being the
+                            // memory of the free portions
+    // Dynamic partitions
+    int fit;
+    hole_t *holes;          // Every hole node, the free ones are linked through left[0]
+    int holes_capacity;
+    int num_hole_nodes;
+    int free_hole;
+    int root[2];            // Roots of the address ordered and the size ordered tree of free holes
+    int num_holes;
+    int free_memory;
+    int next_fit_address;   // Address the next fit search starts from
+    unsigned int random_state;
+    // Buddy system, free_memory is shared with dynamic partitions
+    int max_order;          // The whole memory is one block of 2^max_order Mb
+    int *free_blocks;       // First free block of each order, -1 if there is none
+    int *block_order;       // Order of the free block starting at each address, -1 if no free block starts there
+    int *next_block;        // Free list links of the free block starting at each address
+    int *prev_block;
+    int num_free_blocks;
+    int used_memory;        // Memory the processes asked for, the rest of their blocks is internal fragmentation
+    int internal_fragmentation;
+    // Paging
+    int page_size;
+    int num_frames;
+    int replacement;
+    int fault_time;         // Time in ms to read a page in, spent waiting for an I/O device
+    int access_time;        // Time in ns of a memory reference that does not fault
+    page_node_t *page_nodes;    // Two nodes per frame, the free ones are linked through next
+    int free_page_node;
+    int *frame_page;        // Page node in each frame, -1 if the frame is free
+    int *free_frames;
+    int num_free_frames;
+    int list_front[4];      // Replacement lists, from least to most recently used
+    int list_rear[4];
+    int list_size[4];
+    int arc_target;         // Size ARC aims for T1 to have
+    int clock_hand;
+    int *trace_pids;        // Page trace references, grouped by process
+    int *trace_pages;
+    int num_trace_references;
+    long long page_references;
+    long long page_faults;
+} memory_t;
+
+typedef struct {            // Defines a snapshot being read, which fails as soon as anything in it is out of place
+    FILE *file;
+    _Bool failed;
+} snapshot_reader_t;
+enum { SNAPSHOT_VERSION = 1, SNAPSHOT_HEADER_SIZE = 16 };
+
+enum { HISTOGRAM_BUCKETS = 128 + 24 * 64 };     // Exact up to 127, then 64 buckets for each power of two
+typedef struct {            // Defines a histogram of times with logarithmic buckets, within 1.6% of the exact value
+    long long counts[HISTOGRAM_BUCKETS];
+    long long count;
+    int max;
+} histogram_t;
+
+struct sim {                // Defines the whole state of a simulation, so that several can run side by side
+    sim_config_t config;
+    int time_elapsed;
+    int stop_time;          // Time that an event-driven jump must not go past, -1 if there is none
+    FILE *output;                       // Text output file, NULL if there is none
+    sim_on_transition_t on_transition;  // Receives the transitions instead of the output, NULL if there is none
+    void *transition_context;
+    memory_t *memory;
+    _Bool use_memory_management;
+    _Bool paging;
+    pcb_pool_t *pool;
+    // Arrivals, either from a workload or from a callback that gives each process just before it arrives
+    const sim_process_t *workload;      // Belongs to the caller and may be shared by other simulations
+    int *arrival_order;     // Indices of the workload in order of arrival time, NULL if it already is in order
+    sim_process_t *restored_workload;   // Processes yet to arrive when restored from a snapshot, owned by the
+                                        // simulation, NULL otherwise
+    int workload_size;
+    int next_arrival;
+    sim_next_process_t next_process;    // Gives the processes when streaming, NULL otherwise
+    void *stream_context;
+    sim_process_t upcoming; // Next process to arrive when streaming
+    _Bool has_upcoming;
+    _Bool stream_failed;    // An invalid process was streamed, the simulation stopped when it arrived
+    // A queue for each state in the diagram, each core has its own ready and running queue
+    queue_t *new;
+    queue_t **ready;
+    queue_t **running;
+    queue_t *waiting;       // Processes being served by an I/O device
+    queue_t *io_backlog;    // Waiting processes with no free I/O device
+    queue_t *terminated;
+    queue_t *temp;
+    queue_t *swapped;       // Swapped out processes whose I/O has completed, waiting for memory
+    queue_t *swapping_in;   // Processes being read back from the backing store, ordered by when they are done
+    swap_candidate_t *swap_candidates;  // Node of each pcb of the pool in the tree of processes that can be
+    int swap_capacity;                  // swapped out, grown along with the pool
+    int swap_root;          // -1 if the tree is empty
+    unsigned long long swap_sequence;   // Number of processes that have become swap candidates so far
+    unsigned int swap_random;           // xorshift state of the priorities of the tree
+    _Bool memory_freed;     // A process gave its memory back, or a swapped out process needs it back, during the
+                            // current tick, so admission goes on next tick
+    long long min_vruntime; // Smallest CFS virtual runtime so far, never goes back
+    // Metrics
+    int num_processes;
+    int num_terminated;
+    long long total_cpu_burst_time;     // Totals are wide enough for millions of processes
+    long long total_turnaround_time;
+    long long total_waiting_time;
+    long long total_time_between_io;
+    int num_io;
+    long long num_transitions;
+    int *cpu_busy_time;     // Ticks each core spent executing a process
+    int num_swap_outs;
+    int num_swap_ins;
+    long long swap_traffic; // Mb written to and read from the backing store
+    histogram_t turnaround_times;       // Times of each terminated process
+    histogram_t waiting_times;
+    histogram_t response_times;
+    histogram_t admission_times;
+    int num_deadlines;
+    int num_missed_deadlines;
+    histogram_t lateness_times;
+    int num_periodic;       // Periodic tasks, each counted once however many of its jobs arrive
+    double periodic_utilization;
+    long long *periodic_pids;           // Open addressing set of the pids of the periodic tasks, LLONG_MAX if empty
+    int periodic_capacity;
+    FILE *process_log;      // CSV file of the times of each terminated process, NULL if there is none
+    // Time series, sampled every sample_interval
+    sim_sample_t *samples;  // Ring buffer of the latest samples, NULL if sampling is off
+    int sample_head;        // Index of the oldest sample in the ring buffer
+    int num_samples;
+    int next_sample_time;
+    sim_on_samples_t on_samples;        // Receives the samples whenever the ring buffer fills up, NULL if none
+    void *samples_context;
+};
+
+
+
+// Allocating and initializing functions for structs
+
+static pcb_pool_t *new_pcb_pool(int capacity) {
+    /*
+     * Allocates a pool that can hold capacity pcbs in one contiguous block, which grows when it is full. All
+     * of the pcbs are allocated with new_pcb from this block, and the whole block is freed at once by
+     * free_pcb_pool.
+     */
+
+    pcb_pool_t *pool = malloc(sizeof(pcb_pool_t));
+    assert(pool != NULL);
+
+    pool->pcbs = malloc((capacity > 0 ? capacity : 1) * sizeof(pcb_t));
+    assert(pool->pcbs != NULL);
+    pool->capacity = capacity;
+    pool->size = 0;
+    pool->free_list = -1;
+
+    return pool;
+}
+
+static void reserve_pcb_pool(pcb_pool_t *pool, int capacity) {
+    /*
+     * Grows the block of the pool to hold at least capacity pcbs, so that a workload of known size is
+     * allocated once instead of growing pcb by pcb.
+     */
+
+    if (capacity > pool->capacity) {
+        pool->pcbs = realloc(pool->pcbs, capacity * sizeof(pcb_t));
+        assert(pool->pcbs != NULL);
+        pool->capacity = capacity;
+    }
+}
+
+static void free_pcb_pool(pcb_pool_t *pool) {
+    /*
+     * Frees a pool allocated by new_pcb_pool along with every pcb allocated from it.
+     */
+
+    free(pool->pcbs);
+    free(pool);
+}
+
+static queue_t *new_queue(pcb_pool_t *pool) {
+    /*
+     * Allocates a queue struct on the heap and returns a pointer
+     * to it. Initializes the front and rear indices to -1 and the
+     * queue size to 0. The queue holds pcbs from the given pool.
+     */
+
+    queue_t *queue = malloc(sizeof(queue_t));     // Allocate new queue_t struct on the heap
+    assert(queue != NULL);
+
+    queue->pool = pool;				// Initialize elements of queue (the queue_t struct)
+    queue->front = -1;
+    queue->rear = -1;
+    queue->size = 0;
+    queue->key = NULL;
+    queue->heap = NULL;
+    queue->capacity = 0;
+    queue->next_sequence = 0;
+    queue->num_levels = 0;
+    queue->level_front = NULL;
+    queue->level_rear = NULL;
+    queue->level_bitmap = 0;
+    queue->total_weight = 0;
+    queue->size_tree = NULL;
+    queue->position_pcb = NULL;
+
+    return queue;
+}
+
+static queue_t *new_ordered_queue(pcb_pool_t *pool, long long (*key)(pcb_t *)) {
+    /*
+     * Allocates a queue that keeps its pcbs ordered by the value returned by key, lowest first. Pcbs with
+     * equal keys are kept in the order they were enqueued. The queue is backed by a binary heap, so enqueue
+     * and dequeue are O(log n). The front index always refers to the pcb with the lowest key, the rear
+     * index is not used.
+     */
+
+    queue_t *queue = new_queue(pool);
+    queue->key = key;
+    return queue;
+}
+
+static queue_t *new_level_queue(pcb_pool_t *pool, int num_levels) {
+    /*
+     * Allocates a multilevel queue, which keeps a FIFO queue for each of num_levels levels and enqueues a pcb on
+     * the level it is at. The front index always refers to the front pcb of the highest level that is not empty,
+     * found in O(1) from a bitmap of the levels that hold pcbs. The rear index is not used.
+     */
+
+    queue_t *queue = new_queue(pool);
+    queue->num_levels = num_levels;
+    queue->level_front = malloc(num_levels * sizeof(int));
+    queue->level_rear = malloc(num_levels * sizeof(int));
+    assert((queue->level_front != NULL) && (queue->level_rear != NULL));
+    for (int level = 0; level < num_levels; level++) {
+        queue->level_front[level] = -1;
+        queue->level_rear[level] = -1;
+    }
+    return queue;
+}
+
+static queue_t *new_sized_queue(pcb_pool_t *pool) {
+    /*
+     * Allocates a FIFO queue that can also find its first pcb whose process size is at most a given size in
+     * O(log n). Each pcb is given the next position when it is enqueued, and a tournament tree keeps the
+     * smallest size below each node, with the positions as its leaves. The positions are compacted when they
+     * run out. The rear index is not used.
+     */
+
+    queue_t *queue = new_queue(pool);
+    queue->capacity = 16;
+    queue->size_tree = malloc(2 * queue->capacity * sizeof(int));
+    queue->position_pcb = malloc(queue->capacity * sizeof(int));
+    assert((queue->size_tree != NULL) && (queue->position_pcb != NULL));
+    for (int node = 0; node < 2 * queue->capacity; node++) {
+        queue->size_tree[node] = INT_MAX;
+    }
+    for (int position = 0; position < queue->capacity; position++) {
+        queue->position_pcb[position] = -1;
+    }
+    return queue;
+}
+
+static void free_queue(queue_t *queue) {
+    /*
+     * Frees a queue allocated by new_queue, new_ordered_queue, new_level_queue or new_sized_queue. The pcbs in
+     * the queue are not freed.
+     */
+
+    free(queue->heap);
+    free(queue->level_front);
+    free(queue->level_rear);
+    free(queue->size_tree);
+    free(queue->position_pcb);
+    free(queue);
+}
+
+static int process_weight(int priority) {
+    /*
+     * Returns the CFS weight of a process, which treats its priority as a nice value from -20 to 19. Each
+     * priority level gets about 25% less of the CPU than the one above it, and priority 0 has a weight of 1024.
+     */
+
+    static const int nice_weights[40] = {
+        88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+        9548, 7620, 6100, 4904, 3906, 3121, 2501, 1991, 1586, 1277,
+        1024, 820, 655, 526, 423, 335, 272, 215, 172, 137,
+        110, 87, 70, 56, 45, 36, 29, 23, 18, 15};
+    int nice = (priority < -20) ? -20 : ((priority > 19) ? 19 : priority);
+    return nice_weights[nice + 20];
+}
+
+static pcb_t *new_pcb(pcb_pool_t *pool, int pid, int arrival_time, int total_cpu_time, int io_freq, int io_dur,
+                      int priority, int process_size) {
+    /*
+     * Takes all of the inputted information about a process and stores it in a pcb_t struct allocated
+     * from the pool. Pcbs given back to the pool are reused first. Returns a pointer to the pcb struct, which
+     * stays valid until the pool next has to grow.
+     */
+
+    pcb_t *pcb;
+    if (pool->free_list != -1) {
+        pcb = &pool->pcbs[pool->free_list];
+        pool->free_list = pcb->next;
+    } else {
+        if (pool->size == pool->capacity) {
+            // Grow the block, which moves the pcbs, but the queues only refer to them by index
+            pool->capacity = (pool->capacity > 0) ? 2 * pool->capacity : 64;
+            pool->pcbs = realloc(pool->pcbs, pool->capacity * sizeof(pcb_t));
+            assert(pool->pcbs != NULL);
+        }
+        pcb = &pool->pcbs[pool->size++];
+    }
+
+    pcb->pid = pid;
+    pcb->arrival_time = arrival_time;
+    pcb->remaining_cpu_time = total_cpu_time;
+    pcb->cpu_arrival_time = 0;
+    pcb->io_frequency = io_freq;
+    pcb->io_duration = io_dur;
+    pcb->next = -1;
+    pcb->level = 0;
+    pcb->weight = process_weight(priority);
+    pcb->vruntime = 0;
+    pcb->charged_cpu_time = total_cpu_time;
+    pcb->predicted_burst = 0;
+    pcb->burst_start_cpu_time = total_cpu_time;
+    pcb->expected_burst = 0;
+    pcb->state_entered_time = arrival_time;
+    pcb->admission_time = -1;
+    pcb->first_run_time = -1;
+    pcb->waiting_time = 0;
+    pcb->deadline = LLONG_MAX;
+    pcb->period = LLONG_MAX;
+    pcb->swapped_out = false;
+    pcb->swap_out_done = 0;
+    pcb->priority = priority;
+    pcb->time_until_io = io_freq;
+    if (io_freq == 0) {     // If I/O frequency is 0, set it to be the CPU burst time so I/O never occurs
+        pcb->time_until_io = total_cpu_time;
+    }
+    pcb->base_memory_location = -1;          // Measured in Mb
+    pcb->size_of_process = process_size;     // Measured in Mb
+    pcb->io_completion_time = -1;
+    pcb->io_service_time = io_dur;
+    pcb->queue_position = -1;
+    pcb->page_table = NULL;
+    pcb->num_pages = 0;
+    pcb->next_page = 0;
+    pcb->page_read_in = false;
+    pcb->locality_base = 0;
+    pcb->reference_state = 0;
+    pcb->trace_start = 0;
+    pcb->trace_length = 0;
+    pcb->trace_position = 0;
+
+    return pcb;
+}
+
+static void free_pcb(pcb_pool_t *pool, pcb_t *pcb) {
+    /*
+     * Gives a pcb back to the pool so that new_pcb can reuse it.
+     */
+
+    pcb->next = pool->free_list;
+    pool->free_list = (int) (pcb - pool->pcbs);
+}
+
+
+
+// Queue functions
+
+static pcb_t *queue_front(queue_t *queue) {
+    /*
+     * Returns a pointer to the pcb at the front of the queue, NULL if the queue is empty.
+     */
+
+    return (queue->front == -1) ? NULL : &queue->pool->pcbs[queue->front];
+}
+
+static int first_fitting_position(queue_t *queue, int position, int size) {
+    /*
+     * Returns the first position of a sized queue from position on whose process size is at most size, -1 if
+     * there is none. Climbs until a subtree to the right holds such a size, then goes down to its first leaf.
+     */
+
+    int num_leaves = queue->capacity;
+    if (position >= (int) queue->next_sequence) {
+        return -1;
+    }
+    int node = num_leaves + position;
+    while (queue->size_tree[node] > size) {
+        while (node & 1) {          // The last node of its level below its parent, so the parent is done too
+            node >>= 1;
+        }
+        if (node == 0) {
+            return -1;
+        }
+        node++;
+    }
+    while (node < num_leaves) {
+        node = (queue->size_tree[2 * node] <= size) ? 2 * node : 2 * node + 1;
+    }
+    return node - num_leaves;
+}
+
+static void set_position_size(queue_t *queue, int position, int size) {
+    /*
+     * Sets the size at a position of a sized queue, INT_MAX for a removed pcb, and updates the nodes above it.
+     */
+
+    int node = queue->capacity + position;
+    queue->size_tree[node] = size;
+    for (node >>= 1; node > 0; node >>= 1) {
+        int left = queue->size_tree[2 * node];
+        int right = queue->size_tree[2 * node + 1];
+        queue->size_tree[node] = (left < right) ? left : right;
+    }
+}
+
+static void compact_positions(queue_t *queue) {
+    /*
+     * Gives the pcbs of a sized queue the first positions again, in the same order, in a tree with room for
+     * at least as many pcbs again. Done when the positions run out, so each enqueue costs O(log n) amortized.
+     */
+
+    int num_leaves = 16;
+    while (num_leaves < 2 * (queue->size + 1)) {
+        num_leaves *= 2;
+    }
+    int *size_tree = malloc(2 * num_leaves * sizeof(int));
+    int *position_pcb = malloc(num_leaves * sizeof(int));
+    assert((size_tree != NULL) && (position_pcb != NULL));
+
+    int num_positions = 0;
+    for (int position = 0; position < (int) queue->next_sequence; position++) {
+        int index = queue->position_pcb[position];
+        if (index != -1) {
+            pcb_t *pcb = &queue->pool->pcbs[index];
+            pcb->queue_position = num_positions;
+            position_pcb[num_positions] = index;
+            size_tree[num_leaves + num_positions] = queue->size_tree[queue->capacity + position];
+            num_positions++;
+        }
+    }
+    for (int position = num_positions; position < num_leaves; position++) {
+        position_pcb[position] = -1;
+        size_tree[num_leaves + position] = INT_MAX;
+    }
+    for (int node = num_leaves - 1; node > 0; node--) {
+        int left = size_tree[2 * node];
+        int right = size_tree[2 * node + 1];
+        size_tree[node] = (left < right) ? left : right;
+    }
+
+    free(queue->size_tree);
+    free(queue->position_pcb);
+    queue->size_tree = size_tree;
+    queue->position_pcb = position_pcb;
+    queue->capacity = num_leaves;
+    queue->next_sequence = num_positions;
+    queue->front = (num_positions > 0) ? position_pcb[0] : -1;
+}
+
+static pcb_t *queue_next(queue_t *queue, pcb_t *pcb) {
+    /*
+     * Returns a pointer to the pcb after pcb in a FIFO or sized queue, NULL if pcb is the last one.
+     */
+
+    if (queue->size_tree != NULL) {
+        int position = first_fitting_position(queue, pcb->queue_position + 1, INT_MAX - 1);
+        return (position == -1) ? NULL : &queue->pool->pcbs[queue->position_pcb[position]];
+    }
+    return (pcb->next == -1) ? NULL : &queue->pool->pcbs[pcb->next];
+}
+
+static pcb_t *first_fitting(queue_t *queue, int size) {
+    /*
+     * Returns a pointer to the first pcb of a sized queue whose process size is at most size, NULL if there is
+     * none.
+     */
+
+    size = (size < INT_MAX) ? size : INT_MAX - 1;      // INT_MAX marks the removed pcbs
+    int position = (queue->size > 0) ? first_fitting_position(queue, 0, size) : -1;
+    return (position == -1) ? NULL : &queue->pool->pcbs[queue->position_pcb[position]];
+}
+
+static void remove_from_sized_queue(queue_t *queue, pcb_t *pcb) {
+    /*
+     * Removes any pcb from a sized queue, updating the front index if it was the front pcb.
+     */
+
+    int position = pcb->queue_position;
+    set_position_size(queue, position, INT_MAX);
+    queue->position_pcb[position] = -1;
+    queue->total_weight -= pcb->weight;
+    queue->size -= 1;
+    if (queue->front == (int) (pcb - queue->pool->pcbs)) {
+        position = first_fitting_position(queue, position + 1, INT_MAX - 1);
+        queue->front = (position == -1) ? -1 : queue->position_pcb[position];
+    }
+}
+
+static _Bool heap_entry_less(heap_entry_t *a, heap_entry_t *b) {
+    /*
+     * Returns true if heap entry a comes before heap entry b in an ordered queue.
+     */
+
+    return (a->key < b->key) || ((a->key == b->key) && (a->sequence < b->sequence));
+}
+
+static void heap_push(queue_t *queue, pcb_t *pcb) {
+    /*
+     * Inserts a pcb in the binary heap of an ordered queue and sifts it up to its position.
+     */
+
+    if (queue->size == queue->capacity) {       // Grow the heap when it is full
+        queue->capacity = (queue->capacity == 0) ? 16 : queue->capacity * 2;
+        queue->heap = realloc(queue->heap, queue->capacity * sizeof(heap_entry_t));
+        assert(queue->heap != NULL);
+    }
+
+    heap_entry_t entry = {(int) (pcb - queue->pool->pcbs), queue->key(pcb), queue->next_sequence++};
+    int i = queue->size;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!heap_entry_less(&entry, &queue->heap[parent])) {
+            break;
+        }
+        queue->heap[i] = queue->heap[parent];
+        i = parent;
+    }
+    queue->heap[i] = entry;
+}
+
+static void heap_pop(queue_t *queue) {
+    /*
+     * Removes the first entry from the binary heap of an ordered queue, the last entry is moved to the
+     * root and sifted down. Expects queue->size to still count the removed entry.
+     */
+
+    heap_entry_t last = queue->heap[queue->size - 1];
+    int n = queue->size - 1;
+    int i = 0;
+    while (2 * i + 1 < n) {
+        int child = 2 * i + 1;
+        if ((child + 1 < n) && heap_entry_less(&queue->heap[child + 1], &queue->heap[child])) {
+            child++;
+        }
+        if (!heap_entry_less(&queue->heap[child], &last)) {
+            break;
+        }
+        queue->heap[i] = queue->heap[child];
+        i = child;
+    }
+    queue->heap[i] = last;
+}
+
+static int highest_level(unsigned int level_bitmap) {
+    /*
+     * Returns the lowest set bit of a non-zero level bitmap, which is the highest level holding pcbs. The
+     * lowest bit is isolated and multiplied by a de Bruijn sequence, whose top five bits are then different
+     * for each of the 32 bits.
+     */
+
+    static const int bit_positions[32] = {0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+                                          31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9};
+    return bit_positions[((level_bitmap & (0u - level_bitmap)) * 0x077CB531u) >> 27];
+}
+
+static void merge_levels(queue_t *queue) {
+    /*
+     * Moves every pcb of a multilevel queue to the top level, keeping the order they would have been dequeued
+     * in. The levels are linked one after the other, so only the pcb levels have to be updated by the caller.
+     */
+
+    int front = -1;
+    int rear = -1;
+    while (queue->level_bitmap != 0) {
+        int level = highest_level(queue->level_bitmap);
+        if (front == -1) {
+            front = queue->level_front[level];
+        } else {
+            queue->pool->pcbs[rear].next = queue->level_front[level];
+        }
+        rear = queue->level_rear[level];
+        queue->level_front[level] = -1;
+        queue->level_rear[level] = -1;
+        queue->level_bitmap &= queue->level_bitmap - 1;
+    }
+    if (front != -1) {
+        queue->level_front[0] = front;
+        queue->level_rear[0] = rear;
+        queue->level_bitmap = 1;
+    }
+}
+
+static void enqueue(queue_t *queue, pcb_t *pcb) {
+    /* 
+     * Adds a previously allocated node to the end of the queue pointed to by queue. If the queue is
+     * ordered, the node is inserted according to its key instead.
+     */
+
+    int index = (int) (pcb - queue->pool->pcbs);
+    queue->total_weight += pcb->weight;
+
+    if (queue->key != NULL) {           // Ordered queue, insert in the heap and update the front index
+        heap_push(queue, pcb);
+        queue->size += 1;
+        queue->front = queue->heap[0].pcb;
+        return;
+    }
+
+    if (queue->size_tree != NULL) {     // Sized queue, give the node the next position
+        if ((int) queue->next_sequence == queue->capacity) {
+            compact_positions(queue);
+        }
+        int position = (int) queue->next_sequence++;
+        pcb->queue_position = position;
+        queue->position_pcb[position] = index;
+        set_position_size(queue, position, (pcb->size_of_process < INT_MAX) ? pcb->size_of_process : INT_MAX - 1);
+        if (queue->front == -1) {
+            queue->front = index;
+        }
+        queue->size += 1;
+        return;
+    }
+
+    if (queue->num_levels > 0) {        // Multilevel queue, add the node at the end of its level
+        int level = pcb->level;
+        if (queue->level_front[level] == -1) {
+            queue->level_front[level] = index;
+        } else {
+            queue->pool->pcbs[queue->level_rear[level]].next = index;
+        }
+        queue->level_rear[level] = index;
+        queue->level_bitmap |= 1u << level;
+        queue->size += 1;
+        queue->front = queue->level_front[highest_level(queue->level_bitmap)];
+        return;
+    }
+
+    if (queue->front == -1) {		// If the queue is empty, add node at the front
+        queue->front = index;
+    } else {
+        queue->pool->pcbs[queue->rear].next = index;	//If the queue has other elements, add node at the end
+    }
+
+    queue->rear = index;     			// Set the rear index to refer to the new end of the queue
+    queue->size += 1;				// Increase queue size
+}
+
+static void dequeue(queue_t *queue, _Bool deallocate) {
+    /*
+     * If the queue pointed to by queue is empty, returns false.
+     * If the queue has one or more nodes, removes the front node
+     * and returns true. If the queue ends up with only one node, 
+     * makes sure that the front and rear indices in the queue 
+     * struct both refer to the one node in the list. If deallocate
+     * is true, the node is given back to the pcb pool.
+     */
+
+    if (queue->size == 0) {    					// If the queue is empty, cannot dequeue
+        printf("Queue is empty, cannot dequeue.");
+        assert(false);
+    }
+    pcb_t *pcb_to_delete = queue_front(queue);  // Creates a temporary pointer to the front node
+
+    if (queue->size_tree != NULL) {             // Sized queue, remove the node from its position
+        remove_from_sized_queue(queue, pcb_to_delete);
+        if (deallocate) {
+            free_pcb(queue->pool, pcb_to_delete);
+        }
+        return;
+    }
+    queue->total_weight -= pcb_to_delete->weight;
+
+    if (queue->key != NULL) {                   // Ordered queue, remove the root of the heap
+        heap_pop(queue);
+        queue->size -= 1;
+        queue->front = (queue->size > 0) ? queue->heap[0].pcb : -1;
+    } else if (queue->num_levels > 0) {         // Multilevel queue, remove the front node of the highest level
+        int level = highest_level(queue->level_bitmap);
+        queue->level_front[level] = pcb_to_delete->next;
+        pcb_to_delete->next = -1;
+        if (queue->level_front[level] == -1) {
+            queue->level_rear[level] = -1;
+            queue->level_bitmap &= ~(1u << level);
+        }
+        queue->size -= 1;
+        queue->front = (queue->level_bitmap != 0) ? queue->level_front[highest_level(queue->level_bitmap)] : -1;
+    } else {
+        queue->front = pcb_to_delete->next;		// Remove the node from the queue, set new front
+        pcb_to_delete->next = -1;
+        if (queue->front == -1){				// If list is now empty, set front and rear indices
+            queue->rear = -1;
+        }
+        queue->size -= 1;     					// Decrease queue size
+    }
+
+    if (deallocate) { 							// Determines whether node is given back to the pool
+        free_pcb(queue->pool, pcb_to_delete);
+    }
+}
+
+
+
+// Functions for writing to an output file
+
+void sim_write_transition(FILE *write_file, int transition_identifier, int time, int pid) {
+    /**
+     * Write details about a transition between states to a file. Transition type is determined by 
+     * the int transition_type.
+     * - 0 is new to ready (admitted)
+     * - 1 is ready to running (scheduler dispatch)
+     * - 2 is running to waiting (I/O or event wait)
+     * - 3 is waiting to ready (I/O or event completion)
+     * - 4 is running to ready (interrupt)
+     * - 5 is running to terminated (exit)
+     */
+    
+    // Print out some transition information to the output file.
+    fprintf(write_file, "%-14d %-14d ", time, pid);
+    //fprintf(write_file, "%d %d ", time, old_state->front->pid);
+
+    // These if and else statements determine which states are being transitioned between and write
+    // the corresponding states to the file pointer to by f. The commented out fprintf statements
+    // can be used instead if you want the output file to be less formatted.
+    if ((transition_identifier > 5) || (transition_identifier < 0)) {
+        printf("Incorrect transition identifier");
+        assert(false);
+    } else if (transition_identifier == 0) {
+        fprintf(write_file, "NEW            READY\n\n");  
+        //fprintf(write_file, "NEW READY\n");
+    } else if (transition_identifier == 1) {
+        fprintf(write_file, "READY          RUNNING\n\n");
+        //fprintf(write_file, "READY RUNNING\n");
+    } else if (transition_identifier == 2) {
+        fprintf(write_file, "RUNNING        WAITING\n\n");
+        //fprintf(write_file, "RUNNING WAITING\n");
+    } else if (transition_identifier == 3) {
+        fprintf(write_file, "WAITING        READY\n\n");
+        //fprintf(write_file, "WAITING READY\n");
+    } else if (transition_identifier == 4) {
+        fprintf(write_file, "RUNNING        READY\n\n");
+        //fprintf(write_file, "RUNNING READY\n");
+    } else {
+        fprintf(write_file, "RUNNING        TERMINATED\n\n");
+        //fprintf(write_file, "RUNNING TERMINATED \n");
+    }
+
+    // Display transition details in the terminal (for debugging)
+    //printf("Transition Time: %d, ", (time));
+    //printf("Pid: %d\n\n", (old_state->front->pid));
+}
+
+static void transition(int transition_identifier, queue_t *old_state, queue_t *new_state, sim_t *sim) {
+    /**
+     * Perform a transition between the states provided in old_state and 
+     * new_state. The transition type is determined by the int transition_type:
+     * - 0 is new to ready (admitted)
+     * - 1 is ready to running (scheduler dispatch)
+     * - 2 is running to waiting (I/O or event wait)
+     * - 3 is waiting to ready (I/O or event completion)
+     * - 4 is running to ready (interrupt)
+     * - 5 is running to terminated (exit)
+     * The process is moved from one queue to the next, and the transition is handed to the transition callback
+     * of the simulation, or else written to its output if it has one.
+     */
+    
+    pcb_t *process = queue_front(old_state);
+    sim->num_transitions++;
+
+    // Per-process times, a process is always dispatched from the ready queue
+    if (transition_identifier == 0) {
+        process->admission_time = sim->time_elapsed;
+    } else if (transition_identifier == 1) {
+        process->waiting_time += sim->time_elapsed - process->state_entered_time;
+        if (process->first_run_time == -1) {
+            process->first_run_time = sim->time_elapsed;
+        }
+    }
+    process->state_entered_time = sim->time_elapsed;
+
+    if (sim->on_transition != NULL) {
+        sim->on_transition(sim->transition_context, transition_identifier, sim->time_elapsed, process->pid);
+    } else if (sim->output != NULL) {
+        sim_write_transition(sim->output, transition_identifier, sim->time_elapsed, process->pid);
+    }
+
+    // Move the process from the old state to the new state
+    enqueue(new_state, process);
+    dequeue(old_state, false);
+}
+
+
+
+// Latency histograms
+
+static int highest_bit(unsigned int value) {
+    /*
+     * Returns the highest set bit of a non-zero value. Every bit below it is set, then the result is multiplied
+     * by a de Bruijn-like constant whose top five bits are then different for each of the 32 bits.
+     */
+
+    static const int bit_positions[32] = {0, 9, 1, 10, 13, 21, 2, 29, 11, 14, 16, 18, 22, 25, 3, 30,
+                                          8, 12, 20, 28, 15, 17, 24, 7, 19, 27, 23, 6, 26, 5, 4, 31};
+    value |= value >> 1;
+    value |= value >> 2;
+    value |= value >> 4;
+    value |= value >> 8;
+    value |= value >> 16;
+    return bit_positions[(value * 0x07C4ACDDu) >> 27];
+}
+
+static void record_time(histogram_t *histogram, int time) {
+    /*
+     * Adds a time to the histogram in constant time. Times below 128 ms get a bucket each, and above that
+     * every power of two is split into 64 buckets, so a bucket is never wider than 1/64 of its times.
+     */
+
+    int bucket = time;
+    if (time >= 128) {
+        int shift = highest_bit((unsigned int) time) - 6;
+        bucket = 128 + (shift - 1) * 64 + (time >> shift) - 64;
+    } else if (time < 0) {
+        bucket = 0;
+    }
+    histogram->counts[bucket]++;
+    histogram->count++;
+    if (time > histogram->max) {
+        histogram->max = time;
+    }
+}
+
+static int time_percentile(const histogram_t *histogram, int per_mille) {
+    /*
+     * Returns the time that per_mille thousandths of the recorded times are at or below, as the highest time
+     * of its bucket, or 0 if nothing has been recorded.
+     */
+
+    long long rank = (histogram->count * per_mille + 999) / 1000;
+    if (rank < 1) {
+        rank = 1;
+    }
+    long long seen = 0;
+    for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        seen += histogram->counts[bucket];
+        if (seen >= rank) {
+            long long highest = bucket;
+            if (bucket >= 128) {
+                int shift = (bucket - 128) / 64 + 1;
+                highest = ((long long) ((bucket - 128) % 64 + 65) << shift) - 1;
+            }
+            return (highest < histogram->max) ? (int) highest : histogram->max;
+        }
+    }
+    return 0;
+}
+
+static sim_percentiles_t time_percentiles(const histogram_t *histogram) {
+    /*
+     * Returns the percentiles of the times in the histogram.
+     */
+
+    sim_percentiles_t percentiles;
+    percentiles.p50 = time_percentile(histogram, 500);
+    percentiles.p90 = time_percentile(histogram, 900);
+    percentiles.p99 = time_percentile(histogram, 990);
+    percentiles.p999 = time_percentile(histogram, 999);
+    percentiles.max = histogram->max;
+    return percentiles;
+}
+
+static void record_process(sim_t *sim, const pcb_t *process) {
+    /*
+     * Records the times of a process that terminates now, and writes them to the process log if there is one.
+     */
+
+    int turnaround_time = sim->time_elapsed - process->arrival_time;
+    int response_time = process->first_run_time - process->arrival_time;
+    int admission_time = process->admission_time - process->arrival_time;
+    record_time(&sim->turnaround_times, turnaround_time);
+    record_time(&sim->waiting_times, process->waiting_time);
+    record_time(&sim->response_times, response_time);
+    record_time(&sim->admission_times, admission_time);
+    if (process->deadline != LLONG_MAX) {
+        long long lateness = sim->time_elapsed - process->deadline;
+        sim->num_deadlines++;
+        sim->num_missed_deadlines += (lateness > 0);
+        record_time(&sim->lateness_times, (lateness > 0) ? (int) lateness : 0);
+    }
+    if (sim->process_log != NULL) {
+        fprintf(sim->process_log, "%d,%d,%d,%d,%d,%d,%d,%d,%d\n", process->pid, process->arrival_time,
+                process->admission_time, process->first_run_time, sim->time_elapsed, turnaround_time,
+                process->waiting_time, response_time, admission_time);
+    }
+}
+
+
+
+// Schedulers
+
+static void fcfs_scheduler(int transition_type, queue_t *old_state, queue_t *new_state, sim_t *sim) {
+    /**
+     * This First-come first-Serve (FCFS) scheduler processes queued processes in order of their arrival.
+     */
+
+    // Move the process at the front of the new queue into the ready queue
+    transition(transition_type, old_state, new_state, sim);
+}
+
+static long long priority_key(pcb_t *pcb) {
+    /**
+     * Key of the ready queue used by the external priorities scheduler, lower numbers are higher priority.
+     */
+
+    return pcb->priority;
+}
+
+static void external_priorities_scheduler(int transition_type, queue_t *old_state, queue_t *new_state, sim_t *sim) {
+    /**
+     * This priority-based scheduler sorts the processes in the ready queue based on their priority.
+     * This makes it so that the CPU is allocated to processes with the highest priority first.
+     */
+
+    // The ready queue is an ordered queue keyed by priority_key, so enqueueing the process inserts it after
+    // every process with a higher or equal priority. Equal-priority processes stay in FCFS order.
+    transition(transition_type, old_state, new_state, sim);
+}
+
+static void round_robin_scheduler(int transition_type, queue_t *old_state, queue_t *new_state, sim_t *sim) {
+    /**
+     * Round-robin (RR) scheduling algorithm is similar to FCFS scheduling in that it allocates the CPU to processes
+     * in the order that they arrive. The difference is that it interrupts the CPU after a process has been using the
+     * CPU for a certain amount of time and moves the process back to the end of the ready queue. The amount of time
+     * that each process can have the CPU at one time is specified by the quantum, the quantum is implemented in main.
+     */
+
+    transition(transition_type, old_state, new_state, sim);
+}
+
+static void mlfq_scheduler(int transition_type, queue_t *old_state, queue_t *new_state, sim_t *sim) {
+    /**
+     * The multilevel feedback queue (MLFQ) scheduler keeps a ready queue per level, and runs the processes of a
+     * level in round robin order only when every level above it is empty. Each level has its own quantum, which
+     * usually grows going down. A process that uses up its quantum is interrupted and moves down a level, so
+     * CPU-bound processes sink, and a process coming back from I/O moves up a level. A page fault is not the
+     * process's own doing, so it does not move the process. Every process is periodically boosted back to the
+     * top level, which is done in step, so that the processes at the bottom do not starve.
+     */
+
+    pcb_t *process = queue_front(old_state);
+    if ((transition_type == 4) && (process->level < sim->config.num_levels - 1)) {
+        process->level++;
+    } else if ((transition_type == 3) && !process->page_read_in && (process->level > 0)) {
+        process->level--;
+    }
+    transition(transition_type, old_state, new_state, sim);
+}
+
+static long long vruntime_key(pcb_t *pcb) {
+    /**
+     * Key of the ready queue used by the CFS scheduler, the process that has had the least of its fair share
+     * runs first.
+     */
+
+    return pcb->vruntime;
+}
+
+static void cfs_scheduler(int transition_type, queue_t *old_state, queue_t *new_state, sim_t *sim) {
+    /**
+     * The completely fair scheduler (CFS) tries to give each process a share of the CPU in proportion to its
+     * weight. Each process has a virtual runtime, the CPU time it used divided by its weight, and the ready
+     * queue is ordered by virtual runtime so that the process that is furthest behind runs next. Processes
+     * are interrupted after a timeslice, worked out in process_quantum, and go back into the ready queue.
+     * A new process starts at the smallest virtual runtime, and a process coming back from I/O is moved up to
+     * half a target latency behind it, so that neither can take the CPU over for long.
+     */
+
+    pcb_t *process = queue_front(old_state);
+
+    // Charge the CPU time used since the process last became ready, which is 0 for a new process
+    process->vruntime += (long long) (process->charged_cpu_time - process->remaining_cpu_time) * 1000 * 1024 /
+                         process->weight;
+    process->charged_cpu_time = process->remaining_cpu_time;
+
+    // The smallest virtual runtime only moves forward, it is shared by the cores
+    if ((transition_type == 4) || (new_state->size > 0)) {
+        long long leftmost = (transition_type == 4) ? process->vruntime : queue_front(new_state)->vruntime;
+        if ((new_state->size > 0) && (queue_front(new_state)->vruntime < leftmost)) {
+            leftmost = queue_front(new_state)->vruntime;
+        }
+        if (leftmost > sim->min_vruntime) {
+            sim->min_vruntime = leftmost;
+        }
+    }
+
+    // Place new and woken up processes
+    long long placement = sim->min_vruntime;
+    if (transition_type == 3) {
+        placement -= (long long) sim->config.target_latency * 1000 / 2;
+    }
+    if (((transition_type == 0) || (transition_type == 3)) && (process->vruntime < placement)) {
+        process->vruntime = placement;
+    }
+    transition(transition_type, old_state, new_state, sim);
+}
+
+static int expected_burst(const sim_t *sim, const pcb_t *process) {
+    /**
+     * Returns how much longer the current CPU burst of the process is expected to last: its predicted burst less
+     * the CPU time it has had since the burst started, or the real rest of the burst with the oracle.
+     */
+
+    if (sim->config.oracle_burst) {
+        return (process->time_until_io < process->remaining_cpu_time) ? process->time_until_io
+                                                                      : process->remaining_cpu_time;
+    }
+    int used = process->burst_start_cpu_time - process->remaining_cpu_time;
+    int expected = (int) (process->predicted_burst + 0.5) - used;
+    return (expected > 0) ? expected : 0;
+}
+
+static long long burst_key(pcb_t *pcb) {
+    /**
+     * Key of the ready queue used by the SJF and SRTF schedulers, the shortest expected burst runs first.
+     */
+
+    return pcb->expected_burst;
+}
+
+static void sjf_scheduler(int transition_type, queue_t *old_state, queue_t *new_state, sim_t *sim) {
+    /**
+     * The shortest-job-first (SJF) scheduler runs the ready process whose next CPU burst is expected to be the
+     * shortest. The length of a burst is not known ahead of time, so it is predicted with an exponential
+     * average of the bursts of the process so far: each time a process comes back from I/O, the burst it just
+     * finished is weighted by alpha and the old prediction by 1 - alpha. New processes start with the initial
+     * prediction. The shortest-remaining-time-first (SRTF) scheduler is the preemptive version, where a process
+     * is interrupted as soon as a ready process is expected to finish its burst sooner, which is checked in
+     * step. With the oracle, the real length of the bursts is used instead, which gives the smallest average
+     * waiting time any scheduler can reach.
+     */
+
+    pcb_t *process = queue_front(old_state);
+    if (transition_type == 0) {
+        process->predicted_burst = sim->config.initial_burst;
+    } else if ((transition_type == 3) && !process->page_read_in) {    // A page fault does not end the burst
+        int burst = process->burst_start_cpu_time - process->remaining_cpu_time;
+        process->predicted_burst = sim->config.burst_alpha * burst +
+                                   (1 - sim->config.burst_alpha) * process->predicted_burst;
+        process->burst_start_cpu_time = process->remaining_cpu_time;
+    }
+    process->expected_burst = expected_burst(sim, process);
+    transition(transition_type, old_state, new_state, sim);
+}
+
+static long long deadline_key(pcb_t *pcb) {
+    /**
+     * Key of the ready queue used by the EDF scheduler, the earliest absolute deadline runs first.
+     */
+
+    return pcb->deadline;
+}
+
+static long long period_key(pcb_t *pcb) {
+    /**
+     * Key of the ready queue used by the rate monotonic scheduler, the shortest period runs first.
+     */
+
+    return pcb->period;
+}
+
+static void real_time_scheduler(int transition_type, queue_t *old_state, queue_t *new_state, sim_t *sim) {
+    /**
+     * The earliest-deadline-first (EDF) scheduler runs the ready process whose absolute deadline comes first,
+     * and the rate monotonic (RM) scheduler the one with the shortest period, a fixed priority. Processes
+     * without a deadline or a period run after the others in FCFS order. Both are preemptive: a process is
+     * interrupted as soon as a ready process comes before it, which is checked in step. The ready queue is an
+     * ordered queue keyed by deadline_key or period_key, so the transition alone puts the process in its place.
+     */
+
+    transition(transition_type, old_state, new_state, sim);
+}
+
+static _Bool should_preempt(const sim_t *sim, int core) {
+    /**
+     * Returns true if the process running on the core should be interrupted by the front of its ready queue:
+     * under SRTF if it is expected to finish its burst sooner, under EDF and RM if its key comes first.
+     */
+
+    queue_t *ready = sim->ready[core];
+    if (ready->size == 0) {
+        return false;
+    } else if (sim->config.scheduler_type == 6) {
+        return queue_front(ready)->expected_burst < expected_burst(sim, queue_front(sim->running[core]));
+    } else if ((sim->config.scheduler_type == 7) || (sim->config.scheduler_type == 8)) {
+        return ready->key(queue_front(ready)) < ready->key(queue_front(sim->running[core]));
+    }
+    return false;
+}
+
+static int process_quantum(const sim_t *sim, int core) {
+    /**
+     * Returns how long the process running on the core can run before it is interrupted, the quantum of its
+     * level with the MLFQ scheduler. With the CFS scheduler, the target latency, or the minimum granularity for
+     * each runnable process if that is longer, is split between the runnable processes of the core by weight.
+     * A process that is alone on its core is not interrupted.
+     */
+
+    pcb_t *process = queue_front(sim->running[core]);
+    if (sim->config.scheduler_type == 3) {
+        return sim->config.level_quanta[process->level];
+    } else if (sim->config.scheduler_type == 4) {
+        queue_t *ready = sim->ready[core];
+        if (ready->size == 0) {
+            return 1000000;
+        }
+        long long period = sim->config.target_latency;
+        if ((long long) (ready->size + 1) * sim->config.min_granularity > period) {
+            period = (long long) (ready->size + 1) * sim->config.min_granularity;
+        }
+        long long slice = period * process->weight / (ready->total_weight + process->weight);
+        return (slice > sim->config.min_granularity) ? (int) slice : sim->config.min_granularity;
+    }
+    return sim->config.quantum;
+}
+
+static void boost_priorities(sim_t *sim) {
+    /**
+     * Moves every process back to the top MLFQ level. The ready queues keep their order, the processes that
+     * were higher up stay ahead of the others.
+     */
+
+    for (int i = 0; i < sim->pool->size; i++) {
+        sim->pool->pcbs[i].level = 0;
+    }
+    for (int core = 0; core < sim->config.num_cpus; core++) {
+        merge_levels(sim->ready[core]);
+    }
+}
+
+static void scheduler(int transition_type, queue_t *old_state, queue_t *new_state, sim_t *sim) {
+    /**
+     * This function determines which scheduler should be used based on a parameter passed into the program in the terminal.
+     */
+
+    if (sim->config.scheduler_type == 0) {
+        fcfs_scheduler(transition_type, old_state, new_state, sim);
+    } else if (sim->config.scheduler_type == 1) {
+        external_priorities_scheduler(transition_type, old_state, new_state, sim);
+    } else if (sim->config.scheduler_type == 2) {
+        round_robin_scheduler(transition_type, old_state, new_state, sim);
+    } else if (sim->config.scheduler_type == 3) {
+        mlfq_scheduler(transition_type, old_state, new_state, sim);
+    } else if (sim->config.scheduler_type == 4) {
+        cfs_scheduler(transition_type, old_state, new_state, sim);
+    } else if ((sim->config.scheduler_type == 5) || (sim->config.scheduler_type == 6)) {
+        sjf_scheduler(transition_type, old_state, new_state, sim);
+    } else if ((sim->config.scheduler_type == 7) || (sim->config.scheduler_type == 8)) {
+        real_time_scheduler(transition_type, old_state, new_state, sim);
+    }
+}
+
+
+
+// CPU cores
+
+static queue_t *least_loaded_ready_queue(queue_t *ready[], queue_t *running[], int num_cpus) {
+    /**
+     * Returns the ready queue of the core with the fewest ready and running processes, which is where newly
+     * admitted processes and processes coming back from I/O are scheduled. Ties go to the lowest core.
+     */
+
+    int best = 0;
+    for (int core = 1; core < num_cpus; core++) {
+        if (ready[core]->size + running[core]->size < ready[best]->size + running[best]->size) {
+            best = core;
+        }
+    }
+    return ready[best];
+}
+
+static int count_ready(queue_t *ready[], int num_cpus) {
+    /**
+     * Returns the number of ready processes across all cores.
+     */
+
+    int num_ready = 0;
+    for (int core = 0; core < num_cpus; core++) {
+        num_ready += ready[core]->size;
+    }
+    return num_ready;
+}
+
+static void steal_work(queue_t *ready[], int core, int num_cpus) {
+    /**
+     * Called when a core has no running and no ready process. The core takes the process at the front of the
+     * busiest ready queue, if any, and enqueues it to its own ready queue. The process stays ready, so no
+     * transition is written.
+     */
+
+    int busiest = -1;
+    for (int other = 0; other < num_cpus; other++) {
+        if ((ready[other]->size > 0) && ((busiest == -1) || (ready[other]->size > ready[busiest]->size))) {
+            busiest = other;
+        }
+    }
+    if (busiest != -1) {
+        enqueue(ready[core], queue_front(ready[busiest]));
+        dequeue(ready[busiest], false);
+    }
+}
+
+
+
+// Swap candidates
+
+static _Bool stays_blocked_longer(const swap_candidate_t candidates[], int a, int b) {
+    /*
+     * Tells whether swap candidate a stays blocked longer than b: a process waiting for an I/O device stays
+     * blocked longer than any being served, and the later of two processes with the same rank does.
+     */
+
+    if (candidates[a].rank != candidates[b].rank) {
+        return candidates[a].rank > candidates[b].rank;
+    }
+    return candidates[a].sequence > candidates[b].sequence;
+}
+
+static _Bool swap_candidate_less(const swap_candidate_t candidates[], int a, int b) {
+    /*
+     * Orders the swap candidates by size, then by pool index, so no two candidates are equal.
+     */
+
+    if (candidates[a].size != candidates[b].size) {
+        return candidates[a].size < candidates[b].size;
+    }
+    return a < b;
+}
+
+static void update_swap_candidate(swap_candidate_t candidates[], int node) {
+    /*
+     * Recomputes the candidate that stays blocked the longest in the subtree rooted at node.
+     */
+
+    swap_candidate_t *candidate = &candidates[node];
+    candidate->best = node;
+    if ((candidate->left != -1) && stays_blocked_longer(candidates, candidates[candidate->left].best, candidate->best)) {
+        candidate->best = candidates[candidate->left].best;
+    }
+    if ((candidate->right != -1) &&
+        stays_blocked_longer(candidates, candidates[candidate->right].best, candidate->best)) {
+        candidate->best = candidates[candidate->right].best;
+    }
+}
+
+static int insert_swap_candidate(swap_candidate_t candidates[], int root, int node) {
+    /*
+     * Inserts node into the treap rooted at root as a leaf, rotates it up above the nodes of lower priority,
+     * and returns the new root.
+     */
+
+    if (root == -1) {
+        return node;
+    }
+    if (swap_candidate_less(candidates, node, root)) {
+        int left = insert_swap_candidate(candidates, candidates[root].left, node);
+        candidates[root].left = left;
+        if (candidates[left].priority > candidates[root].priority) {
+            candidates[root].left = candidates[left].right;
+            update_swap_candidate(candidates, root);
+            candidates[left].right = root;
+            root = left;
+        }
+    } else {
+        int right = insert_swap_candidate(candidates, candidates[root].right, node);
+        candidates[root].right = right;
+        if (candidates[right].priority > candidates[root].priority) {
+            candidates[root].right = candidates[right].left;
+            update_swap_candidate(candidates, root);
+            candidates[right].left = root;
+            root = right;
+        }
+    }
+    update_swap_candidate(candidates, root);
+    return root;
+}
+
+static int merge_swap_candidates(swap_candidate_t candidates[], int a, int b) {
+    /*
+     * Joins two treaps where every candidate in a is ordered before every candidate in b and returns the new
+     * root.
+     */
+
+    if ((a == -1) || (b == -1)) {
+        return (a == -1) ? b : a;
+    }
+    int root;
+    if (candidates[a].priority > candidates[b].priority) {
+        candidates[a].right = merge_swap_candidates(candidates, candidates[a].right, b);
+        root = a;
+    } else {
+        candidates[b].left = merge_swap_candidates(candidates, a, candidates[b].left);
+        root = b;
+    }
+    update_swap_candidate(candidates, root);
+    return root;
+}
+
+static int delete_swap_candidate(swap_candidate_t candidates[], int root, int node) {
+    /*
+     * Unlinks node from the treap rooted at root, putting its two subtrees together in its place, and returns
+     * the new root.
+     */
+
+    if (root == node) {
+        return merge_swap_candidates(candidates, candidates[root].left, candidates[root].right);
+    }
+    if (swap_candidate_less(candidates, node, root)) {
+        candidates[root].left = delete_swap_candidate(candidates, candidates[root].left, node);
+    } else {
+        candidates[root].right = delete_swap_candidate(candidates, candidates[root].right, node);
+    }
+    update_swap_candidate(candidates, root);
+    return root;
+}
+
+static void add_swap_candidate(sim_t *sim, pcb_t *process, long long rank) {
+    /*
+     * Makes a process that just blocked a candidate to be swapped out, with its rank: LLONG_MAX if it waits
+     * for an I/O device, otherwise the time its I/O completes. Only processes holding memory are candidates,
+     * and only when swapping is on.
+     */
+
+    if (!sim->config.swapping || process->swapped_out || (process->size_of_process <= 0)) {
+        return;
+    }
+    if (sim->swap_capacity < sim->pool->capacity) {
+        sim->swap_candidates = realloc(sim->swap_candidates, sim->pool->capacity * sizeof(swap_candidate_t));
+        assert(sim->swap_candidates != NULL);
+        memset(sim->swap_candidates + sim->swap_capacity, 0,
+               (sim->pool->capacity - sim->swap_capacity) * sizeof(swap_candidate_t));
+        sim->swap_capacity = sim->pool->capacity;
+    }
+
+    // xorshift priorities keep the tree balanced on average while runs stay reproducible
+    sim->swap_random ^= sim->swap_random << 13;
+    sim->swap_random ^= sim->swap_random >> 17;
+    sim->swap_random ^= sim->swap_random << 5;
+
+    int node = (int) (process - sim->pool->pcbs);
+    swap_candidate_t *candidate = &sim->swap_candidates[node];
+    candidate->size = process->size_of_process;
+    candidate->in_tree = true;
+    candidate->priority = sim->swap_random;
+    candidate->rank = rank;
+    candidate->sequence = sim->swap_sequence++;
+    candidate->left = -1;
+    candidate->right = -1;
+    candidate->best = node;
+    sim->swap_root = insert_swap_candidate(sim->swap_candidates, sim->swap_root, node);
+}
+
+static void remove_swap_candidate(sim_t *sim, pcb_t *process) {
+    /*
+     * Takes a process out of the swap candidates, when it stops being blocked or is swapped out. Does nothing
+     * if it is not a candidate.
+     */
+
+    int node = (int) (process - sim->pool->pcbs);
+    if ((node >= sim->swap_capacity) || !sim->swap_candidates[node].in_tree) {
+        return;
+    }
+    sim->swap_root = delete_swap_candidate(sim->swap_candidates, sim->swap_root, node);
+    sim->swap_candidates[node].in_tree = false;
+}
+
+
+
+// I/O devices
+
+static long long io_completion_key(pcb_t *pcb) {
+    /**
+     * Key of the waiting queue, processes being served by an I/O device are ordered by the time their I/O
+     * completes so that the next completion is always at the front of the queue.
+     */
+
+    return pcb->io_completion_time;
+}
+
+static void start_io(sim_t *sim, queue_t *old_state, int service_time) {
+    /**
+     * Moves the process at the front of old_state into the waiting state for an I/O that takes service_time.
+     * If one of the I/O devices is free (0 devices means there is one device per process), the process is
+     * served right away and enters the waiting queue with the time its I/O completes. Otherwise it enters the
+     * I/O backlog until a device frees up.
+     */
+
+    pcb_t *process = queue_front(old_state);
+    process->io_service_time = service_time;
+    if ((sim->config.io_devices == 0) || (sim->waiting->size < sim->config.io_devices)) {
+        process->io_completion_time = sim->time_elapsed + process->io_service_time;
+        transition(2, old_state, sim->waiting, sim);
+        add_swap_candidate(sim, process, process->io_completion_time);
+    } else {
+        transition(2, old_state, sim->io_backlog, sim);
+        add_swap_candidate(sim, process, LLONG_MAX);
+    }
+}
+
+static void complete_io(sim_t *sim) {
+    /**
+     * Moves every process whose I/O completes at the current time from waiting to the ready queue of the
+     * least loaded core. The device that served it then starts serving the process at the front of the
+     * I/O backlog.
+     */
+
+    queue_t *waiting = sim->waiting;
+    while ((waiting->size > 0) && (queue_front(waiting)->io_completion_time <= sim->time_elapsed)) {
+        remove_swap_candidate(sim, queue_front(waiting));
+        if (queue_front(waiting)->swapped_out) {    // Its memory has to be swapped back in before it is ready
+            enqueue(sim->swapped, queue_front(waiting));
+            dequeue(waiting, false);
+            sim->memory_freed = true;
+        } else {
+            scheduler(3, waiting, least_loaded_ready_queue(sim->ready, sim->running, sim->config.num_cpus), sim);
+        }
+        if (sim->io_backlog->size > 0) {
+            pcb_t *process = queue_front(sim->io_backlog);
+            process->io_completion_time = sim->time_elapsed + process->io_service_time;
+            enqueue(waiting, process);
+            dequeue(sim->io_backlog, false);
+            remove_swap_candidate(sim, process);
+            add_swap_candidate(sim, process, process->io_completion_time);
+        }
+    }
+}
+
+
+
+// Memory Management
+
+static int block_order_for(int size) {
+    /*
+     * Returns the order of the smallest buddy block that can hold size Mb.
+     */
+
+    int order = 0;
+    while ((1 << order) < size) {
+        order++;
+    }
+    return order;
+}
+
+static void push_free_block(memory_t *memory, int address, int order) {
+    /*
+     * Adds the block at address to the front of the free list of its order.
+     */
+
+    memory->block_order[address] = order;
+    memory->prev_block[address] = -1;
+    memory->next_block[address] = memory->free_blocks[order];
+    if (memory->free_blocks[order] != -1) {
+        memory->prev_block[memory->free_blocks[order]] = address;
+    }
+    memory->free_blocks[order] = address;
+    memory->num_free_blocks++;
+    memory->free_memory += 1 << order;
+}
+
+static void remove_free_block(memory_t *memory, int address) {
+    /*
+     * Unlinks the free block at address from the free list of its order.
+     */
+
+    int order = memory->block_order[address];
+    if (memory->prev_block[address] != -1) {
+        memory->next_block[memory->prev_block[address]] = memory->next_block[address];
+    } else {
+        memory->free_blocks[order] = memory->next_block[address];
+    }
+    if (memory->next_block[address] != -1) {
+        memory->prev_block[memory->next_block[address]] = memory->prev_block[address];
+    }
+    memory->block_order[address] = -1;
+    memory->num_free_blocks--;
+    memory->free_memory -= 1 << order;
+}
+
+static int new_hole(memory_t *memory, int address, int size) {
+    /*
+     * Takes a hole node from the memory's node array, growing the array if every node is in use, and returns
+     * its index. The hole is not part of either tree until it is inserted.
+     */
+
+    int index;
+    if (memory->free_hole != -1) {
+        index = memory->free_hole;
+        memory->free_hole = memory->holes[index].left[0];
+    } else {
+        if (memory->num_hole_nodes == memory->holes_capacity) {
+            memory->holes_capacity *= 2;
+            memory->holes = realloc(memory->holes, memory->holes_capacity * sizeof(hole_t));
+            assert(memory->holes != NULL);
+        }
+        index = memory->num_hole_nodes++;
+    }
+
+    // xorshift priorities keep the trees balanced on average while runs stay reproducible
+    memory->random_state ^= memory->random_state << 13;
+    memory->random_state ^= memory->random_state >> 17;
+    memory->random_state ^= memory->random_state << 5;
+
+    hole_t *hole = &memory->holes[index];
+    hole->address = address;
+    hole->size = size;
+    hole->priority = memory->random_state;
+    hole->left[0] = hole->left[1] = -1;
+    hole->right[0] = hole->right[1] = -1;
+    hole->max_size = size;
+    return index;
+}
+
+static _Bool hole_less(memory_t *memory, int tree, int a, int b) {
+    /*
+     * Orders holes by address in tree 0 and by size, then address, in tree 1. No two holes share an
+     * address, so neither order has ties.
+     */
+
+    hole_t *x = &memory->holes[a];
+    hole_t *y = &memory->holes[b];
+    if ((tree == 1) && (x->size != y->size)) {
+        return x->size < y->size;
+    }
+    return x->address < y->address;
+}
+
+static void update_hole(memory_t *memory, int node) {
+    /*
+     * Recomputes the largest hole size in the subtree of the address ordered tree rooted at node.
+     */
+
+    hole_t *hole = &memory->holes[node];
+    hole->max_size = hole->size;
+    for (int child = 0; child < 2; child++) {
+        int c = (child == 0) ? hole->left[0] : hole->right[0];
+        if ((c != -1) && (memory->holes[c].max_size > hole->max_size)) {
+            hole->max_size = memory->holes[c].max_size;
+        }
+    }
+}
+
+static void split_holes(memory_t *memory, int tree, int root, int key, int *less, int *rest) {
+    /*
+     * Splits the treap rooted at root into the holes ordered before the key hole and the rest.
+     */
+
+    if (root == -1) {
+        *less = -1;
+        *rest = -1;
+    } else if (hole_less(memory, tree, root, key)) {
+        split_holes(memory, tree, memory->holes[root].right[tree], key, &memory->holes[root].right[tree], rest);
+        *less = root;
+    } else {
+        split_holes(memory, tree, memory->holes[root].left[tree], key, less, &memory->holes[root].left[tree]);
+        *rest = root;
+    }
+    if ((tree == 0) && (root != -1)) {
+        update_hole(memory, root);
+    }
+}
+
+static int merge_holes(memory_t *memory, int tree, int a, int b) {
+    /*
+     * Joins two treaps where every hole in a is ordered before every hole in b and returns the new root.
+     */
+
+    if ((a == -1) || (b == -1)) {
+        return (a == -1) ? b : a;
+    }
+    int root;
+    if (memory->holes[a].priority > memory->holes[b].priority) {
+        memory->holes[a].right[tree] = merge_holes(memory, tree, memory->holes[a].right[tree], b);
+        root = a;
+    } else {
+        memory->holes[b].left[tree] = merge_holes(memory, tree, a, memory->holes[b].left[tree]);
+        root = b;
+    }
+    if (tree == 0) {
+        update_hole(memory, root);
+    }
+    return root;
+}
+
+static int remove_first_hole(memory_t *memory, int tree, int root) {
+    /*
+     * Unlinks the first hole of the treap rooted at root and returns the new root.
+     */
+
+    if (memory->holes[root].left[tree] == -1) {
+        return memory->holes[root].right[tree];
+    }
+    memory->holes[root].left[tree] = remove_first_hole(memory, tree, memory->holes[root].left[tree]);
+    if (tree == 0) {
+        update_hole(memory, root);
+    }
+    return root;
+}
+
+static void insert_hole(memory_t *memory, int node) {
+    /*
+     * Adds a hole to both the address ordered and the size ordered tree.
+     */
+
+    memory->holes[node].max_size = memory->holes[node].size;
+    for (int tree = 0; tree < 2; tree++) {
+        int less;
+        int rest;
+        memory->holes[node].left[tree] = -1;
+        memory->holes[node].right[tree] = -1;
+        split_holes(memory, tree, memory->root[tree], node, &less, &rest);
+        memory->root[tree] = merge_holes(memory, tree, merge_holes(memory, tree, less, node), rest);
+    }
+    memory->num_holes++;
+    memory->free_memory += memory->holes[node].size;
+}
+
+static void remove_hole(memory_t *memory, int node, _Bool deallocate) {
+    /*
+     * Removes a hole from both trees. If deallocate is true the node is also given back to the node array,
+     * otherwise it can be changed and inserted again.
+     */
+
+    for (int tree = 0; tree < 2; tree++) {
+        int less;
+        int rest;
+        split_holes(memory, tree, memory->root[tree], node, &less, &rest);
+        memory->root[tree] = merge_holes(memory, tree, less, remove_first_hole(memory, tree, rest));
+    }
+    memory->num_holes--;
+    memory->free_memory -= memory->holes[node].size;
+    if (deallocate) {
+        memory->holes[node].left[0] = memory->free_hole;
+        memory->free_hole = node;
+    }
+}
+
+static int first_fit_hole(memory_t *memory, int root, int size) {
+    /*
+     * Returns the lowest addressed hole in the subtree that can hold size, or -1 if there is none. The
+     * largest hole size of each subtree decides which way to go without looking at the other holes.
+     */
+
+    while ((root != -1) && (memory->holes[root].max_size >= size)) {
+        int left = memory->holes[root].left[0];
+        if ((left != -1) && (memory->holes[left].max_size >= size)) {
+            root = left;
+        } else if (memory->holes[root].size >= size) {
+            return root;
+        } else {
+            root = memory->holes[root].right[0];
+        }
+    }
+    return -1;
+}
+
+static int next_fit_hole(memory_t *memory, int root, int address, int size) {
+    /*
+     * Returns the lowest addressed hole at or after address that can hold size, or -1 if there is none.
+     */
+
+    if ((root == -1) || (memory->holes[root].max_size < size)) {
+        return -1;
+    }
+    if (memory->holes[root].address < address) {
+        return next_fit_hole(memory, memory->holes[root].right[0], address, size);
+    }
+    int found = next_fit_hole(memory, memory->holes[root].left[0], address, size);
+    if (found != -1) {
+        return found;
+    }
+    if (memory->holes[root].size >= size) {
+        return root;
+    }
+    return first_fit_hole(memory, memory->holes[root].right[0], size);
+}
+
+static int find_hole(memory_t *memory, int size) {
+    /*
+     * Returns the hole that the fit policy of the memory picks for a process of the given size, or -1 if
+     * no hole is large enough.
+     */
+
+    int node = -1;
+    int root;
+    switch (memory->fit) {
+        case FIRST_FIT:
+            return first_fit_hole(memory, memory->root[0], size);
+        case NEXT_FIT:
+            // Search on from the end of the last allocation and wrap around to the start of memory
+            node = next_fit_hole(memory, memory->root[0], memory->next_fit_address, size);
+            return (node != -1) ? node : first_fit_hole(memory, memory->root[0], size);
+        case BEST_FIT:
+            // The first hole in size order that is big enough
+            root = memory->root[1];
+            while (root != -1) {
+                if (memory->holes[root].size >= size) {
+                    node = root;
+                    root = memory->holes[root].left[1];
+                } else {
+                    root = memory->holes[root].right[1];
+                }
+            }
+            return node;
+        default:
+            // The lowest addressed of the biggest holes, whose size is kept at the root of the address tree
+            root = memory->root[0];
+            if ((root == -1) || (memory->holes[root].max_size < size)) {
+                return -1;
+            }
+            return first_fit_hole(memory, root, memory->holes[root].max_size);
+    }
+}
+
+static int neighbouring_hole(memory_t *memory, int address, _Bool after) {
+    /*
+     * Returns the hole with the closest address before (or after) the given address, or -1 if there is none.
+     */
+
+    int node = -1;
+    int root = memory->root[0];
+    while (root != -1) {
+        if (after ? (memory->holes[root].address > address) : (memory->holes[root].address < address)) {
+            node = root;
+            root = after ? memory->holes[root].left[0] : memory->holes[root].right[0];
+        } else {
+            root = after ? memory->holes[root].right[0] : memory->holes[root].left[0];
+        }
+    }
+    return node;
+}
+
+static int compare_page_references(const void *a, const void *b) {
+    /*
+     * Orders page trace references by pid, then by their line in the trace.
+     */
+
+    const page_reference_t *x = a;
+    const page_reference_t *y = b;
+    if (x->pid != y->pid) {
+        return (x->pid < y->pid) ? -1 : 1;
+    }
+    return (x->order > y->order) - (x->order < y->order);
+}
+
+static int new_page_node(memory_t *memory) {
+    /*
+     * Takes a free page node and returns its index. There are two nodes per frame, which is as many pages as
+     * ARC keeps track of, so a node is always free when one is needed.
+     */
+
+    int node = memory->free_page_node;
+    assert(node != -1);
+    memory->free_page_node = memory->page_nodes[node].next;
+    return node;
+}
+
+static void append_page(memory_t *memory, int node, int list) {
+    /*
+     * Adds a page to the rear of a replacement list, which is the most recently used end.
+     */
+
+    page_node_t *page = &memory->page_nodes[node];
+    page->list = list;
+    page->prev = memory->list_rear[list];
+    page->next = -1;
+    if (memory->list_rear[list] != -1) {
+        memory->page_nodes[memory->list_rear[list]].next = node;
+    } else {
+        memory->list_front[list] = node;
+    }
+    memory->list_rear[list] = node;
+    memory->list_size[list]++;
+}
+
+static void unlink_page(memory_t *memory, int node) {
+    /*
+     * Removes a page from the replacement list it is on.
+     */
+
+    page_node_t *page = &memory->page_nodes[node];
+    if (page->prev != -1) {
+        memory->page_nodes[page->prev].next = page->next;
+    } else {
+        memory->list_front[page->list] = page->next;
+    }
+    if (page->next != -1) {
+        memory->page_nodes[page->next].prev = page->prev;
+    } else {
+        memory->list_rear[page->list] = page->prev;
+    }
+    memory->list_size[page->list]--;
+}
+
+static void load_page(memory_t *memory, int node, int list) {
+    /*
+     * Puts a page that is not on any list into a free frame and adds it to the given list.
+     */
+
+    assert(memory->num_free_frames > 0);
+    page_node_t *page = &memory->page_nodes[node];
+    page->frame = memory->free_frames[--memory->num_free_frames];
+    page->referenced = true;
+    memory->frame_page[page->frame] = node;
+    page->page_table[page->page] = node;
+    append_page(memory, node, list);
+}
+
+static void evict_page(memory_t *memory, int node, int ghost_list) {
+    /*
+     * Takes a page out of its frame and off its list. ARC moves it to one of its ghost lists, which remember
+     * pages without holding them, every other page is forgotten and its node is freed (ghost_list is -1).
+     */
+
+    page_node_t *page = &memory->page_nodes[node];
+    unlink_page(memory, node);
+    if (page->frame != -1) {
+        memory->frame_page[page->frame] = -1;
+        memory->free_frames[memory->num_free_frames++] = page->frame;
+        page->frame = -1;
+    }
+    if (ghost_list != -1) {
+        append_page(memory, node, ghost_list);
+    } else {
+        page->page_table[page->page] = -1;
+        page->next = memory->free_page_node;
+        memory->free_page_node = node;
+    }
+}
+
+static void arc_replace(memory_t *memory, _Bool in_b2) {
+    /*
+     * Frees a frame the way ARC does, by evicting the least recently used page of T1 if T1 is over its target
+     * size and of T2 otherwise. The evicted page is remembered on the matching ghost list.
+     */
+
+    int t1 = memory->list_size[ARC_T1];
+    if ((t1 > 0) && ((t1 > memory->arc_target) || (in_b2 && (t1 == memory->arc_target)) ||
+                     (memory->list_size[ARC_T2] == 0))) {
+        evict_page(memory, memory->list_front[ARC_T1], ARC_B1);
+    } else {
+        evict_page(memory, memory->list_front[ARC_T2], ARC_B2);
+    }
+}
+
+static void arc_fault(memory_t *memory, pcb_t *process, int page) {
+    /*
+     * Brings a page in under ARC. A page on a ghost list was evicted too early, so the target size of T1 is
+     * moved towards the list that would have kept it and the page goes straight to T2, the frequency list.
+     * A page seen for the first time goes to T1, the recency list.
+     */
+
+    int node = process->page_table[page];
+    int c = memory->num_frames;
+    int *size = memory->list_size;
+
+    if ((node != -1) && (memory->page_nodes[node].list == ARC_B1)) {
+        int delta = (size[ARC_B2] > size[ARC_B1]) ? size[ARC_B2] / size[ARC_B1] : 1;
+        memory->arc_target = (memory->arc_target + delta < c) ? memory->arc_target + delta : c;
+        if (memory->num_free_frames == 0) {
+            arc_replace(memory, false);
+        }
+        unlink_page(memory, node);
+        load_page(memory, node, ARC_T2);
+        return;
+    }
+    if ((node != -1) && (memory->page_nodes[node].list == ARC_B2)) {
+        int delta = (size[ARC_B1] > size[ARC_B2]) ? size[ARC_B1] / size[ARC_B2] : 1;
+        memory->arc_target = (memory->arc_target - delta > 0) ? memory->arc_target - delta : 0;
+        if (memory->num_free_frames == 0) {
+            arc_replace(memory, true);
+        }
+        unlink_page(memory, node);
+        load_page(memory, node, ARC_T2);
+        return;
+    }
+
+    // Keep T1 and B1 to c pages and all four lists to 2c pages
+    if (size[ARC_T1] + size[ARC_B1] >= c) {
+        if (size[ARC_T1] < c) {
+            evict_page(memory, memory->list_front[ARC_B1], -1);
+        } else {
+            evict_page(memory, memory->list_front[ARC_T1], -1);
+        }
+    } else if (size[ARC_T1] + size[ARC_T2] + size[ARC_B1] + size[ARC_B2] >= 2 * c) {
+        evict_page(memory, memory->list_front[ARC_B2], -1);
+    }
+    if (memory->num_free_frames == 0) {
+        arc_replace(memory, false);
+    }
+
+    node = new_page_node(memory);
+    memory->page_nodes[node].page_table = process->page_table;
+    memory->page_nodes[node].page = page;
+    memory->page_nodes[node].frame = -1;
+    load_page(memory, node, ARC_T1);
+}
+
+static void next_page_reference(memory_t *memory, pcb_t *process) {
+    /*
+     * Picks the page the process references next. With a page trace the process replays its references in
+     * order, starting over when it runs out. Otherwise references are spread over a few neighbouring pages
+     * and every so often move to another part of the process.
+     */
+
+    if (process->trace_length > 0) {
+        process->next_page = memory->trace_pages[process->trace_start + process->trace_position];
+        process->trace_position = (process->trace_position + 1) % process->trace_length;
+        return;
+    }
+
+    unsigned int *state = &process->reference_state;
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    if (*state % LOCALITY_REFERENCES == 0) {
+        process->locality_base = (*state / LOCALITY_REFERENCES) % process->num_pages;
+    }
+    process->next_page = (process->locality_base + (*state >> 8) % LOCALITY_PAGES) % process->num_pages;
+}
+
+static _Bool reference_page(memory_t *memory, pcb_t *process) {
+    /*
+     * Makes the next memory reference of a running process. Returns true if the page is in a frame. On a page
+     * fault the page is given a frame, evicting another page if there is no free frame, and false is returned
+     * so that the process can wait for the page to be read in. The reference that faulted then goes ahead
+     * the next time the process runs, even if the page has been evicted again in the meantime, so that a
+     * thrashing process still makes progress. Either way the process moves on to its next reference.
+     */
+
+    if (process->num_pages == 0) {
+        return true;
+    }
+    if (process->page_read_in) {
+        process->page_read_in = false;
+        return true;
+    }
+
+    int node = process->page_table[process->next_page];
+    memory->page_references++;
+    if ((node != -1) && (memory->page_nodes[node].frame != -1)) {
+        if (memory->replacement == LRU_REPLACEMENT) {
+            unlink_page(memory, node);
+            append_page(memory, node, 0);
+        } else if (memory->replacement == ARC_REPLACEMENT) {
+            unlink_page(memory, node);
+            append_page(memory, node, ARC_T2);
+        }
+        memory->page_nodes[node].referenced = true;
+        next_page_reference(memory, process);
+        return true;
+    }
+
+    memory->page_faults++;
+    if (memory->replacement == ARC_REPLACEMENT) {
+        arc_fault(memory, process, process->next_page);
+        next_page_reference(memory, process);
+        process->page_read_in = true;
+        return false;
+    }
+    if (memory->num_free_frames == 0) {
+        if (memory->replacement == CLOCK_REPLACEMENT) {
+            // Give every referenced page a second chance, the hand stops at the first page that has none
+            while (memory->page_nodes[memory->frame_page[memory->clock_hand]].referenced) {
+                memory->page_nodes[memory->frame_page[memory->clock_hand]].referenced = false;
+                memory->clock_hand = (memory->clock_hand + 1) % memory->num_frames;
+            }
+            evict_page(memory, memory->frame_page[memory->clock_hand], -1);
+            memory->clock_hand = (memory->clock_hand + 1) % memory->num_frames;
+        } else {
+            // FIFO and LRU both evict the front of the list, LRU moves every referenced page to the rear
+            evict_page(memory, memory->list_front[0], -1);
+        }
+    }
+    node = new_page_node(memory);
+    memory->page_nodes[node].page_table = process->page_table;
+    memory->page_nodes[node].page = process->next_page;
+    memory->page_nodes[node].frame = -1;
+    load_page(memory, node, 0);
+    next_page_reference(memory, process);
+    process->page_read_in = true;
+    return false;
+}
+
+static _Bool load_page_trace(const char file_name[], memory_t *memory) {
+    /*
+     * Reads a page trace, one "pid page" reference per line, and groups the references by process, keeping
+     * the order they appear in the file. Each process is given its own references when it is admitted.
+     * Returns false if the file cannot be read.
+     */
+
+    FILE *file = fopen(file_name, "r");
+    if (file == NULL) {
+        printf("\nERROR >>> The page trace %s could not be opened\n", file_name);
+        return false;
+    }
+
+    int capacity = 1024;
+    int num_references = 0;
+    page_reference_t *references = malloc(capacity * sizeof(page_reference_t));
+    assert(references != NULL);
+    int pid;
+    int page;
+    while (fscanf(file, "%d %d", &pid, &page) == 2) {
+        if (num_references == capacity) {
+            capacity *= 2;
+            references = realloc(references, capacity * sizeof(page_reference_t));
+            assert(references != NULL);
+        }
+        references[num_references].pid = pid;
+        references[num_references].page = page;
+        references[num_references].order = num_references;
+        num_references++;
+    }
+    fclose(file);
+
+    qsort(references, num_references, sizeof(page_reference_t), compare_page_references);
+    memory->trace_pids = malloc((num_references > 0 ? num_references : 1) * sizeof(int));
+    memory->trace_pages = malloc((num_references > 0 ? num_references : 1) * sizeof(int));
+    assert((memory->trace_pids != NULL) && (memory->trace_pages != NULL));
+    for (int i = 0; i < num_references; i++) {
+        memory->trace_pids[i] = references[i].pid;
+        memory->trace_pages[i] = references[i].page;
+    }
+    memory->num_trace_references = num_references;
+    free(references);
+    return true;
+}
+
+static int first_trace_reference(const memory_t *memory, int pid) {
+    /*
+     * Binary search for the first reference of a process in the page trace, which is sorted by pid.
+     */
+
+    int low = 0;
+    int high = memory->num_trace_references;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (memory->trace_pids[middle] < pid) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static _Bool page_trace_fits(const memory_t *memory, int pid, int num_pages) {
+    /*
+     * Checks that every page a process references in the page trace is one of its num_pages pages, so that
+     * the trace is found to be wrong before the simulation runs rather than when the process is admitted.
+     */
+
+    for (int i = first_trace_reference(memory, pid);
+         (i < memory->num_trace_references) && (memory->trace_pids[i] == pid); i++) {
+        if ((memory->trace_pages[i] < 0) || (memory->trace_pages[i] >= num_pages)) {
+            printf("\nERROR >>> Process %d references page %d in the page trace but only has %d pages\n", pid,
+                   memory->trace_pages[i], num_pages);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void find_page_trace(memory_t *memory, pcb_t *process) {
+    /*
+     * Points the process at its references in the page trace, which were checked against its pages when it
+     * was loaded. Processes without references in the trace use the locality model instead.
+     */
+
+    int low = first_trace_reference(memory, process->pid);
+    process->trace_start = low;
+    while ((low < memory->num_trace_references) && (memory->trace_pids[low] == process->pid)) {
+        low++;
+    }
+    process->trace_length = low - process->trace_start;
+}
+
+static memory_t *new_fixed_memory(int portion_sizes[], int num_portions) {
+    /*
+     * Allocates a memory made of fixed partitions with the given sizes. Each partition holds at most one
+     * process no matter how much of the partition the process uses.
+     */
+
+    memory_t *memory = calloc(1, sizeof(memory_t));
+    assert(memory != NULL);
+
+    memory->mode = FIXED_PARTITIONS;
+    memory->num_portions = num_portions;
+    memory->portions = malloc((num_portions > 0 ? num_portions : 1) * sizeof(int[2]));
+    assert(memory->portions != NULL);
+    for (int i = 0; i < num_portions; i++) {
+        memory->portions[i][0] = portion_sizes[i];
+        memory->portions[i][1] = 0;
+        memory->total_size += portion_sizes[i];
+    }
+    memory->free_memory = memory->total_size;
+    memory->root[0] = -1;
+    memory->root[1] = -1;
+
+    return memory;
+}
+
+static memory_t *new_dynamic_memory(int size, int fit) {
+    /*
+     * Allocates a memory made of one address range of the given size. Each process is given exactly the
+     * amount of memory it needs out of a free hole chosen by the fit policy.
+     */
+
+    memory_t *memory = calloc(1, sizeof(memory_t));
+    assert(memory != NULL);
+
+    memory->mode = DYNAMIC_PARTITIONS;
+    memory->total_size = size;
+    memory->fit = fit;
+    memory->holes_capacity = 16;
+    memory->holes = malloc(memory->holes_capacity * sizeof(hole_t));
+    assert(memory->holes != NULL);
+    memory->free_hole = -1;
+    memory->root[0] = -1;
+    memory->root[1] = -1;
+    memory->random_state = 2463534242u;
+
+    // The whole address range starts out as a single hole
+    if (size > 0) {
+        insert_hole(memory, new_hole(memory, 0, size));
+    }
+
+    return memory;
+}
+
+static void free_memory(memory_t *memory) {
+    /*
+     * Frees a memory allocated by new_fixed_memory or new_dynamic_memory.
+     */
+
+    free(memory->portions);
+    free(memory->holes);
+    free(memory->free_blocks);
+    free(memory->block_order);
+    free(memory->next_block);
+    free(memory->prev_block);
+    free(memory->page_nodes);
+    free(memory->frame_page);
+    free(memory->free_frames);
+    free(memory->trace_pids);
+    free(memory->trace_pages);
+    free(memory);
+}
+
+static memory_t *new_buddy_memory(int size) {
+    /*
+     * Allocates a buddy system memory of the given size, which must be a power of two. Each process is given
+     * the smallest power of two block that holds it, made by splitting bigger blocks in halves.
+     */
+
+    assert((size > 0) && ((size & (size - 1)) == 0));
+    memory_t *memory = calloc(1, sizeof(memory_t));
+    assert(memory != NULL);
+
+    memory->mode = BUDDY_SYSTEM;
+    memory->total_size = size;
+    memory->root[0] = -1;
+    memory->root[1] = -1;
+    while ((1 << memory->max_order) < size) {
+        memory->max_order++;
+    }
+    memory->free_blocks = malloc((memory->max_order + 1) * sizeof(int));
+    memory->block_order = malloc(size * sizeof(int));
+    memory->next_block = malloc(size * sizeof(int));
+    memory->prev_block = malloc(size * sizeof(int));
+    assert((memory->free_blocks != NULL) && (memory->block_order != NULL) && (memory->next_block != NULL) &&
+           (memory->prev_block != NULL));
+    for (int order = 0; order <= memory->max_order; order++) {
+        memory->free_blocks[order] = -1;
+    }
+    for (int address = 0; address < size; address++) {
+        memory->block_order[address] = -1;
+    }
+
+    // The whole memory starts out as a single free block
+    push_free_block(memory, 0, memory->max_order);
+
+    return memory;
+}
+
+static memory_t *new_paged_memory(int num_frames, int page_size, int replacement, int fault_time, int access_time) {
+    /*
+     * Allocates a paged memory with num_frames frames of page_size Mb each. A process is admitted with an
+     * empty page table and its pages are brought into frames the first time they are referenced.
+     */
+
+    memory_t *memory = calloc(1, sizeof(memory_t));
+    assert(memory != NULL);
+
+    memory->mode = PAGING;
+    memory->total_size = num_frames * page_size;
+    memory->root[0] = -1;
+    memory->root[1] = -1;
+    memory->page_size = page_size;
+    memory->num_frames = num_frames;
+    memory->replacement = replacement;
+    memory->fault_time = fault_time;
+    memory->access_time = access_time;
+    memory->page_nodes = malloc(2 * num_frames * sizeof(page_node_t));
+    memory->frame_page = malloc(num_frames * sizeof(int));
+    memory->free_frames = malloc(num_frames * sizeof(int));
+    assert((memory->page_nodes != NULL) && (memory->frame_page != NULL) && (memory->free_frames != NULL));
+    for (int node = 0; node < 2 * num_frames; node++) {
+        memory->page_nodes[node].next = (node + 1 < 2 * num_frames) ? node + 1 : -1;
+    }
+    memory->free_page_node = 0;
+    for (int frame = 0; frame < num_frames; frame++) {
+        memory->frame_page[frame] = -1;
+        memory->free_frames[frame] = num_frames - 1 - frame;    // Frames are handed out from 0 up
+    }
+    memory->num_free_frames = num_frames;
+    for (int list = 0; list < 4; list++) {
+        memory->list_front[list] = -1;
+        memory->list_rear[list] = -1;
+    }
+
+    return memory;
+}
+
+static _Bool memory_has_free_space(memory_t *memory) {
+    /*
+     * Returns false when no process can possibly be given memory, so admission can be skipped.
+     */
+
+    if (memory->mode == FIXED_PARTITIONS) {
+        return memory->num_allocated < memory->num_portions;
+    } else if (memory->mode == BUDDY_SYSTEM) {
+        return memory->num_free_blocks > 0;
+    } else if (memory->mode == PAGING) {
+        return true;        // Every process can be admitted, only its pages compete for frames
+    }
+    return memory->num_holes > 0;
+}
+
+static int free_usable_memory(memory_t *memory) {
+    /*
+     * Returns the memory in Mb that can still be given to processes: the free portions of fixed partitions,
+     * the free holes or blocks, or the free frames with paging.
+     */
+
+    if (memory->mode == PAGING) {
+        return memory->num_free_frames * memory->page_size;
+    }
+    return memory->free_memory;
+}
+
+static int largest_allocation(memory_t *memory) {
+    /*
+     * Returns the size of the largest process that allocate_memory would give memory to, -1 if not even a
+     * process without memory would get any. Allocating only ever makes it smaller, so admission can go straight
+     * to the first process of new that fits instead of trying each one.
+     */
+
+    if (memory->mode == FIXED_PARTITIONS) {
+        int largest = -1;
+        for (int i = 0; i < memory->num_portions; i++) {
+            if ((memory->portions[i][1] == 0) && (memory->portions[i][0] > largest)) {
+                largest = memory->portions[i][0];
+            }
+        }
+        return largest;
+    } else if (memory->mode == BUDDY_SYSTEM) {
+        for (int order = memory->max_order; order >= 0; order--) {
+            if (memory->free_blocks[order] != -1) {
+                return 1 << order;
+            }
+        }
+        return 0;       // Processes without memory need no block
+    } else if (memory->mode == PAGING) {
+        return INT_MAX;
+    }
+    return (memory->root[0] != -1) ? memory->holes[memory->root[0]].max_size : 0;
+}
+
+static _Bool allocate_fixed_memory(pcb_t *process, memory_t *memory, FILE *write_file) {
+    /**
+     * This function returns true if the memory requirments have been successfully allocated to
+	 * memory hole. Otherwise it returns false. This function also prints out information about
+     * each process that has memory allocated to it.
+     */
+
+    int (*portions)[2] = memory->portions;
+    int size = process->size_of_process;
+    int current_address = 0;
+    int i = 0;
+
+    // Find the first free memory portion large enough for the process, current_address holds its position
+    while ((i < memory->num_portions) && ((portions[i][1] != 0) || (portions[i][0] < size))) {
+        current_address += portions[i][0];
+        i++;
+    }
+    if (i == memory->num_portions) {
+        return false;
+    }
+    portions[i][1] = size;
+    process->base_memory_location = current_address;
+    memory->num_allocated++;
+
+    // The memory metrics are running counters, a process without memory leaves its portion free
+    if (size != 0) {
+        memory->num_used_portions++;
+        memory->used_memory += size;
+        memory->free_memory -= portions[i][0];
+    }
+
+    // Write the memory metrics to the output file
+    if (write_file != NULL) {
+        fprintf(write_file, "MEMORY HAS BEEN ALLOCATED TO PROCESS %d\n", process->pid);
+        fprintf(write_file, "Total used memory: %d Mb\n", memory->used_memory);
+        fprintf(write_file, "Used memory portions: %d\nFree memory portions: %d\n", memory->num_used_portions, memory->num_portions - memory->num_used_portions);
+        fprintf(write_file, "Total amount of free memory: %d Mb\n", memory->total_size - memory->used_memory);
+        fprintf(write_file, "Total amount of free usable memory: %d Mb\n\n", memory->free_memory);
+    }
+    return true;
+}
+
+static _Bool allocate_dynamic_memory(pcb_t *process, memory_t *memory, FILE *write_file) {
+    /*
+     * Carves the memory of a process out of the hole picked by the fit policy, leaving whatever the process
+     * does not use as a smaller hole. Writes the same memory metrics as allocate_fixed_memory, where the
+     * portions are the allocated blocks and the free holes.
+     */
+
+    int size = process->size_of_process;
+    if (size == 0) {
+        // A process without memory needs no hole, it only counts as allocated
+        process->base_memory_location = memory->total_size;
+    } else {
+        int node = find_hole(memory, size);
+        if (node == -1) {
+            return false;
+        }
+        process->base_memory_location = memory->holes[node].address;
+        remove_hole(memory, node, memory->holes[node].size == size);
+        if (memory->holes[node].size > size) {
+            memory->holes[node].address += size;
+            memory->holes[node].size -= size;
+            insert_hole(memory, node);
+        }
+        memory->next_fit_address = process->base_memory_location + size;
+    }
+    memory->num_allocated++;
+
+    if (write_file == NULL) {       // No output file, with a binary transition log or in a sweep
+        return true;
+    }
+    int largest_hole = (memory->root[0] != -1) ? memory->holes[memory->root[0]].max_size : 0;
+    fprintf(write_file, "MEMORY HAS BEEN ALLOCATED TO PROCESS %d\n", process->pid);
+    fprintf(write_file, "Total used memory: %d Mb\n", memory->total_size - memory->free_memory);
+    fprintf(write_file, "Used memory portions: %d\nFree memory portions: %d\n", memory->num_allocated, memory->num_holes);
+    fprintf(write_file, "Total amount of free memory: %d Mb\n", memory->free_memory);
+    fprintf(write_file, "Total amount of free usable memory: %d Mb\n", memory->free_memory);
+    fprintf(write_file, "Largest free hole: %d Mb\n\n", largest_hole);
+    return true;
+}
+
+static _Bool allocate_buddy_memory(pcb_t *process, memory_t *memory, FILE *write_file) {
+    /*
+     * Gives the process the smallest power of two block that holds it, splitting the smallest free block
+     * that is big enough in halves until it has the right size. Writes the memory metrics where the portions
+     * are the allocated and the free blocks, along with the memory lost inside the allocated blocks.
+     */
+
+    int size = process->size_of_process;
+    if (size == 0) {
+        // A process without memory needs no block, it only counts as allocated
+        process->base_memory_location = memory->total_size;
+    } else {
+        int need = block_order_for(size);
+        int order = need;
+        while ((order <= memory->max_order) && (memory->free_blocks[order] == -1)) {
+            order++;
+        }
+        if (order > memory->max_order) {
+            return false;
+        }
+
+        // Split the block, keeping the lower half and freeing the upper half each time
+        int address = memory->free_blocks[order];
+        remove_free_block(memory, address);
+        while (order > need) {
+            order--;
+            push_free_block(memory, address + (1 << order), order);
+        }
+        process->base_memory_location = address;
+        memory->used_memory += size;
+        memory->internal_fragmentation += (1 << need) - size;
+    }
+    memory->num_allocated++;
+
+    if (write_file == NULL) {
+        return true;
+    }
+    fprintf(write_file, "MEMORY HAS BEEN ALLOCATED TO PROCESS %d\n", process->pid);
+    fprintf(write_file, "Total used memory: %d Mb\n", memory->used_memory);
+    fprintf(write_file, "Used memory portions: %d\nFree memory portions: %d\n", memory->num_allocated, memory->num_free_blocks);
+    fprintf(write_file, "Total amount of free memory: %d Mb\n", memory->total_size - memory->used_memory);
+    fprintf(write_file, "Total amount of free usable memory: %d Mb\n", memory->free_memory);
+    fprintf(write_file, "Internal fragmentation: %d Mb\n\n", memory->internal_fragmentation);
+    return true;
+}
+
+static _Bool allocate_paged_memory(pcb_t *process, memory_t *memory, FILE *write_file) {
+    /*
+     * Gives the process an empty page table, so it is always admitted, and picks its first memory reference.
+     */
+
+    process->num_pages = (process->size_of_process + memory->page_size - 1) / memory->page_size;
+    process->page_table = malloc((process->num_pages > 0 ? process->num_pages : 1) * sizeof(int));
+    assert(process->page_table != NULL);
+    for (int page = 0; page < process->num_pages; page++) {
+        process->page_table[page] = -1;
+    }
+    process->base_memory_location = 0;
+    process->reference_state = 2654435761u * (unsigned int) process->pid + 1;
+    process->locality_base = 0;
+    process->trace_position = 0;
+    process->page_read_in = false;
+    find_page_trace(memory, process);
+    if (process->num_pages > 0) {
+        next_page_reference(memory, process);
+    }
+    memory->num_allocated++;
+
+    if (write_file == NULL) {
+        return true;
+    }
+    fprintf(write_file, "MEMORY HAS BEEN ALLOCATED TO PROCESS %d\n", process->pid);
+    fprintf(write_file, "Pages: %d\n", process->num_pages);
+    fprintf(write_file, "Free frames: %d\n\n", memory->num_free_frames);
+    return true;
+}
+
+static _Bool allocate_memory(pcb_t *process, memory_t *memory, FILE *write_file) {
+    /*
+     * Returns true if the process has been given memory by the allocator of the memory's mode.
+     */
+
+    if (memory->mode == FIXED_PARTITIONS) {
+        return allocate_fixed_memory(process, memory, write_file);
+    } else if (memory->mode == BUDDY_SYSTEM) {
+        return allocate_buddy_memory(process, memory, write_file);
+    } else if (memory->mode == PAGING) {
+        return allocate_paged_memory(process, memory, write_file);
+    }
+    return allocate_dynamic_memory(process, memory, write_file);
+}
+
+static void deallocate_fixed_memory(pcb_t *process, memory_t *memory) {
+    /**
+     * This function deallocates memory allocated by the allocate_fixed_memory function.
+     */
+    
+    int current_address = 0;
+
+    // Iterate through memory portions
+    for (int i = 0; i < memory->num_portions; i++) {
+        // If the memory portion is the one allocated to the process stored in process, deallocate it
+        if ((current_address == process->base_memory_location) && (memory->portions[i][1] != 0)) {
+            process->base_memory_location = -1;
+            memory->num_used_portions--;
+            memory->used_memory -= memory->portions[i][1];
+            memory->free_memory += memory->portions[i][0];
+            memory->portions[i][1] = 0;
+            break;
+        }
+        current_address += memory->portions[i][0];
+    }
+}
+
+static void deallocate_dynamic_memory(pcb_t *process, memory_t *memory) {
+    /*
+     * Gives the block of a process back as a hole, merged with the holes directly before and after it.
+     */
+
+    int address = process->base_memory_location;
+    int size = process->size_of_process;
+    process->base_memory_location = -1;
+    if (size == 0) {
+        return;
+    }
+
+    int before = neighbouring_hole(memory, address, false);
+    int after = neighbouring_hole(memory, address, true);
+    if ((after != -1) && (memory->holes[after].address == address + size)) {
+        size += memory->holes[after].size;
+        remove_hole(memory, after, true);
+    }
+    if ((before != -1) && (memory->holes[before].address + memory->holes[before].size == address)) {
+        remove_hole(memory, before, false);
+        memory->holes[before].size += size;
+        insert_hole(memory, before);
+    } else {
+        insert_hole(memory, new_hole(memory, address, size));
+    }
+}
+
+static void deallocate_buddy_memory(pcb_t *process, memory_t *memory) {
+    /*
+     * Gives the block of a process back, merging it with its buddy for as long as the buddy is free.
+     */
+
+    int address = process->base_memory_location;
+    int size = process->size_of_process;
+    process->base_memory_location = -1;
+    if (size == 0) {
+        return;
+    }
+
+    int order = block_order_for(size);
+    memory->used_memory -= size;
+    memory->internal_fragmentation -= (1 << order) - size;
+    while (order < memory->max_order) {
+        int buddy = address ^ (1 << order);
+        if (memory->block_order[buddy] != order) {
+            break;
+        }
+        remove_free_block(memory, buddy);
+        address &= ~(1 << order);
+        order++;
+    }
+    push_free_block(memory, address, order);
+}
+
+static void deallocate_paged_memory(pcb_t *process, memory_t *memory) {
+    /*
+     * Frees the frames of every page of the process and forgets the pages ARC remembers, then the page table.
+     */
+
+    for (int page = 0; page < process->num_pages; page++) {
+        if (process->page_table[page] != -1) {
+            evict_page(memory, process->page_table[page], -1);
+        }
+    }
+    free(process->page_table);
+    process->page_table = NULL;
+    process->num_pages = 0;
+    process->base_memory_location = -1;
+}
+
+static void deallocate_memory(pcb_t *process, memory_t *memory) {
+    /**
+     * This function deallocates memory allocated by the allocate_memory function.
+     */
+
+    if (memory->mode == FIXED_PARTITIONS) {
+        deallocate_fixed_memory(process, memory);
+    } else if (memory->mode == BUDDY_SYSTEM) {
+        deallocate_buddy_memory(process, memory);
+    } else if (memory->mode == PAGING) {
+        deallocate_paged_memory(process, memory);
+    } else {
+        deallocate_dynamic_memory(process, memory);
+    }
+    memory->num_allocated--;
+}
+
+
+
+// Medium-term scheduler
+
+static pcb_t *swap_victim(sim_t *sim, int size) {
+    /*
+     * Returns the blocked process to swap out to make room for a process of the given size, NULL if there is
+     * none. Only a process at least as big is picked, since giving its memory back always makes room whatever
+     * the memory mode. The process that will stay blocked the longest is picked: the last one waiting for an
+     * I/O device, or else the one whose I/O completes last. The candidates at least as big are a node and its
+     * right subtree at each step down the tree, so the search takes the depth of the tree.
+     */
+
+    swap_candidate_t *candidates = sim->swap_candidates;
+    int victim = -1;
+    int node = sim->swap_root;
+    while (node != -1) {
+        if (candidates[node].size >= size) {
+            int right = candidates[node].right;
+            if ((victim == -1) || stays_blocked_longer(candidates, node, victim)) {
+                victim = node;
+            }
+            if ((right != -1) && stays_blocked_longer(candidates, candidates[right].best, victim)) {
+                victim = candidates[right].best;
+            }
+            node = candidates[node].left;
+        } else {
+            node = candidates[node].right;
+        }
+    }
+    return (victim != -1) ? &sim->pool->pcbs[victim] : NULL;
+}
+
+static void swap_out(sim_t *sim) {
+    /*
+     * Admits the processes at the front of new that did not fit in memory by swapping out blocked processes.
+     * The memory of a swapped out process is written to the backing store, which takes swap_time, but its
+     * memory is given to the process at the front of new straight away. Stops at the first process of new that
+     * no blocked process can make room for.
+     */
+
+    while (sim->new->size > 0) {
+        pcb_t *process = queue_front(sim->new);
+        pcb_t *victim = swap_victim(sim, process->size_of_process);
+        if (victim == NULL) {
+            return;
+        }
+        remove_swap_candidate(sim, victim);
+        deallocate_memory(victim, sim->memory);
+        victim->swapped_out = true;
+        victim->swap_out_done = sim->time_elapsed + sim->config.swap_time;
+        sim->num_swap_outs++;
+        sim->swap_traffic += victim->size_of_process;
+        sim->memory_freed = true;
+        if (sim->output != NULL) {
+            fprintf(sim->output, "PROCESS %d HAS BEEN SWAPPED OUT\n\n", victim->pid);
+        }
+        if (!allocate_memory(process, sim->memory, sim->output)) {
+            return;
+        }
+        scheduler(0, sim->new, least_loaded_ready_queue(sim->ready, sim->running, sim->config.num_cpus), sim);
+    }
+}
+
+static void swap_in(sim_t *sim) {
+    /*
+     * Gives memory back to the swapped out processes whose I/O has completed, in the order it completed, for as
+     * long as they fit. Reading a process back from the backing store takes swap_time, and starts once the copy
+     * written when it was swapped out is complete.
+     */
+
+    queue_t *swapped = sim->swapped;
+    while ((swapped->size > 0) && allocate_memory(queue_front(swapped), sim->memory, sim->output)) {
+        pcb_t *process = queue_front(swapped);
+        int start = (process->swap_out_done > sim->time_elapsed) ? process->swap_out_done : sim->time_elapsed;
+        process->io_completion_time = start + sim->config.swap_time;
+        process->swapped_out = false;
+        sim->num_swap_ins++;
+        sim->swap_traffic += process->size_of_process;
+        enqueue(sim->swapping_in, process);
+        dequeue(swapped, false);
+    }
+}
+
+static void complete_swap_in(sim_t *sim) {
+    /*
+     * Moves the processes that have been read back from the backing store to the ready queue of the least loaded
+     * core. They were blocked all along as far as the transitions go, so they go from waiting to ready.
+     */
+
+    queue_t *swapping_in = sim->swapping_in;
+    while ((swapping_in->size > 0) && (queue_front(swapping_in)->io_completion_time <= sim->time_elapsed)) {
+        scheduler(3, swapping_in, least_loaded_ready_queue(sim->ready, sim->running, sim->config.num_cpus), sim);
+    }
+}
+
+
+
+// Time series sampling
+
+static void record_sample(sim_t *sim, int time) {
+    /*
+     * Adds a sample of the queue sizes, the busy cores and the memory to the ring buffer. A full ring buffer is
+     * handed to the samples callback and emptied, or else the oldest sample is overwritten.
+     */
+
+    if ((sim->num_samples == sim->config.sample_buffer) && (sim->on_samples != NULL)) {
+        sim->on_samples(sim->samples_context, sim->samples, sim->num_samples);
+        sim->sample_head = 0;
+        sim->num_samples = 0;
+    }
+    sim_sample_t *sample;
+    if (sim->num_samples == sim->config.sample_buffer) {
+        sample = &sim->samples[sim->sample_head];
+        sim->sample_head = (sim->sample_head + 1) % sim->config.sample_buffer;
+    } else {
+        sample = &sim->samples[(sim->sample_head + sim->num_samples) % sim->config.sample_buffer];
+        sim->num_samples++;
+    }
+
+    sample->time = time;
+    sample->new_size = sim->new->size;
+    sample->ready_size = count_ready(sim->ready, sim->config.num_cpus);
+    sample->waiting_size = sim->waiting->size + sim->io_backlog->size;
+    sample->busy_cpus = 0;
+    for (int core = 0; core < sim->config.num_cpus; core++) {
+        sample->busy_cpus += sim->running[core]->size;
+    }
+    sample->used_portions = sim->use_memory_management ? sim->memory->num_allocated : 0;
+    sample->free_usable_memory = sim->use_memory_management ? free_usable_memory(sim->memory) : 0;
+}
+
+static void take_samples(sim_t *sim) {
+    /*
+     * Samples every sample time up to the start of the current tick. In event-driven mode the ticks that were
+     * skipped had the same queues and memory as the start of the current tick, so they are all sampled now.
+     */
+
+    while (sim->next_sample_time <= sim->time_elapsed) {
+        record_sample(sim, sim->next_sample_time);
+        sim->next_sample_time += sim->config.sample_interval;
+    }
+}
+
+
+
+// Arrival ordering
+
+static int *sort_by_arrival_time(const sim_process_t processes[], int num_processes) {
+    /**
+     * Returns the indices of the processes ordered by arrival time, so that a simulation only has to look at the
+     * next index to find the processes arriving at a given time. The indices are sorted with a merge sort, which is
+     * stable, processes that arrive at the same time keep the order they had in the input file. Returns NULL if
+     * the processes already are in order, which is the case for most workloads, so that they need no indices.
+     */
+
+    _Bool sorted = true;
+    for (int i = 1; (i < num_processes) && sorted; i++) {
+        sorted = (processes[i - 1].arrival_time <= processes[i].arrival_time);
+    }
+    if (sorted) {
+        return NULL;
+    }
+
+    int *order = malloc(num_processes * sizeof(int));
+    int *buffer = malloc(num_processes * sizeof(int));
+    assert((order != NULL) && (buffer != NULL));
+    for (int i = 0; i < num_processes; i++) {
+        order[i] = i;
+    }
+
+    // Merge runs of width 1, 2, 4, ... from order into buffer, then swap the roles of the two arrays
+    int *from = order;
+    int *to = buffer;
+    for (int width = 1; width < num_processes; width *= 2) {
+        for (int start = 0; start < num_processes; start += 2 * width) {
+            int middle = (start + width < num_processes) ? start + width : num_processes;
+            int end = (start + 2 * width < num_processes) ? start + 2 * width : num_processes;
+            int left = start;
+            int right = middle;
+            for (int i = start; i < end; i++) {
+                // Taking from the left run on ties is what keeps the sort stable
+                if ((left < middle) &&
+                    ((right >= end) || (processes[from[left]].arrival_time <= processes[from[right]].arrival_time))) {
+                    to[i] = from[left++];
+                } else {
+                    to[i] = from[right++];
+                }
+            }
+        }
+        int *swap = from;
+        from = to;
+        to = swap;
+    }
+
+    // Copy the result back if the last merge left it in buffer
+    if (from != order) {
+        memcpy(order, from, num_processes * sizeof(int));
+    }
+    free(buffer);
+    return order;
+}
+
+static const sim_process_t *workload_process(const sim_t *sim, int i) {
+    /**
+     * Returns the process of the workload that is the i-th to arrive.
+     */
+
+    return &sim->workload[(sim->arrival_order != NULL) ? sim->arrival_order[i] : i];
+}
+
+
+
+// Event-driven simulation
+
+static int next_arrival_time(const sim_t *sim) {
+    /**
+     * Returns the arrival time of the next process to arrive, -1 if every process has arrived.
+     */
+
+    if (sim->next_process != NULL) {
+        return sim->has_upcoming ? sim->upcoming.arrival_time : -1;
+    }
+    return (sim->next_arrival < sim->workload_size) ? workload_process(sim, sim->next_arrival)->arrival_time : -1;
+}
+
+static int next_event_time(sim_t *sim) {
+    /**
+     * Returns the next time at which the simulation has something to do, assuming that it has just finished
+     * processing time_elapsed. Every tick strictly between time_elapsed and the returned time would only decrement
+     * the running processes and accumulate metrics, so the simulation can apply those ticks in bulk and jump
+     * straight to the returned time. The candidates are:
+     * - the next arrival time, -1 if every process has arrived
+     * - the next I/O completion, at the front of the waiting queue
+     * - the next swap in completion
+     * - the tick where a running process terminates, requests I/O or exceeds its quantum
+     * - the next tick, if a ready process should preempt a running one under SRTF, EDF or RM
+     * - the next tick, if a blocked process can be swapped out to admit the front of new
+     * - the next tick, if a process is ready but a core is free or if memory was freed for admission
+     * - the next tick, if a running process has pages, since it makes a memory reference every tick
+     * - the next MLFQ priority boost
+     */
+
+    int time_elapsed = sim->time_elapsed;
+    int num_cpus = sim->config.num_cpus;
+    int next_event = next_arrival_time(sim);
+
+    // Next priority boost
+    int boost_interval = sim->config.boost_interval;
+    if ((sim->config.scheduler_type == 3) && (boost_interval > 0)) {
+        int next_boost = (time_elapsed / boost_interval + 1) * boost_interval;
+        if ((next_event == -1) || (next_boost < next_event)) {
+            next_event = next_boost;
+        }
+    }
+
+    // A process that was preempted, or that is ready after a running process left, is dispatched (or stolen by
+    // an idle core) next tick
+    if (sim->memory_freed) {
+        return time_elapsed + 1;
+    }
+    if (count_ready(sim->ready, num_cpus) > 0) {
+        for (int core = 0; core < num_cpus; core++) {
+            if (sim->running[core]->size == 0) {
+                return time_elapsed + 1;
+            }
+        }
+    }
+
+    // A process that blocked makes room for the front of new, which swaps it out next tick
+    if (sim->config.swapping && (sim->new->size > 0) &&
+        (swap_victim(sim, queue_front(sim->new)->size_of_process) != NULL)) {
+        return time_elapsed + 1;
+    }
+
+    // A running process that SRTF, EDF or RM preempts is interrupted next tick
+    for (int core = 0; core < num_cpus; core++) {
+        if ((sim->running[core]->size > 0) && should_preempt(sim, core)) {
+            return time_elapsed + 1;
+        }
+    }
+
+    // Next I/O completion
+    if ((sim->waiting->size > 0) &&
+        ((next_event == -1) || (queue_front(sim->waiting)->io_completion_time < next_event))) {
+        next_event = queue_front(sim->waiting)->io_completion_time;
+    }
+
+    // Next swap in completion
+    if ((sim->swapping_in->size > 0) &&
+        ((next_event == -1) || (queue_front(sim->swapping_in)->io_completion_time < next_event))) {
+        next_event = queue_front(sim->swapping_in)->io_completion_time;
+    }
+
+    // Next running process event, each process is checked at the start of each tick and decremented otherwise
+    for (int core = 0; core < num_cpus; core++) {
+        if (sim->running[core]->size == 0) {
+            continue;
+        }
+        pcb_t *process = queue_front(sim->running[core]);
+        if (sim->paging && (process->num_pages > 0)) {
+            return time_elapsed + 1;
+        }
+        int ticks = process->remaining_cpu_time;
+        if ((process->time_until_io >= 0) && (process->time_until_io < ticks)) {
+            ticks = process->time_until_io;
+        }
+        int ticks_until_interrupt = process->cpu_arrival_time + process_quantum(sim, core) - time_elapsed;
+        if (ticks_until_interrupt < 0) {
+            ticks_until_interrupt = 0;
+        }
+        if (ticks_until_interrupt < ticks) {
+            ticks = ticks_until_interrupt;
+        }
+        if ((next_event == -1) || (time_elapsed + 1 + ticks < next_event)) {
+            next_event = time_elapsed + 1 + ticks;
+        }
+    }
+
+    // Nothing is scheduled to happen, fall back to stepping one tick at a time
+    if (next_event == -1) {
+        next_event = time_elapsed + 1;
+    }
+    return next_event;
+}
+
+
+
+// Error handling
+
+static _Bool error_handling(const sim_process_t processes[], int num_processes, memory_t *memory,
+                            _Bool use_memory_management) {
+    /*
+     * This function is designed to catch any problematic values in the input text file and print descriptive
+     * error statements. It does not prevent any errors caused by an incorrectly formatted input file, only
+     * accounts for situations where an input value could caused the program to enter an infinite loop or other
+     * problematic situation. Returns false if any process is invalid.
+     */
+
+    // Find the biggest memory portion
+    int biggest_portion = 0;
+    if (use_memory_management && (memory->mode != FIXED_PARTITIONS)) {
+        biggest_portion = memory->total_size;      // A process can take up the whole memory
+    } else if (use_memory_management) {
+        for (int i = 0; i < memory->num_portions; i++) {
+            if (memory->portions[i][0] > biggest_portion) {
+            biggest_portion = memory->portions[i][0];
+            }
+        }
+    }
+
+
+    _Bool exit = false;
+
+    // Iterate through all of the processes in the input file
+    for (int i = 0; i < num_processes; i++) {
+
+        // Make sure that no process requires more memory than the largest memory portion
+        if (((processes[i].size_of_process) > biggest_portion) && use_memory_management && (memory->mode != PAGING)) {
+            printf("\nERROR >>> Process %d requires %d Mb of memory\n", processes[i].pid, processes[i].size_of_process);
+            printf("There is no memory portion large enough to hold the process as the largest portion is %d Mb\n", biggest_portion);
+            exit = true;
+        }
+
+        // Make sure that all process inputs except pid and priority are positive
+        if ((processes[i].arrival_time < 0) || (processes[i].total_cpu_time < 0) || (processes[i].io_frequency < 0) || 
+            (processes[i].io_duration < 0) || (processes[i].size_of_process < 0) || (processes[i].deadline < 0) ||
+            (processes[i].period < 0)) {
+                printf("\nERROR >>> Process %d has an invalid negative input\n", processes[i].pid);
+                exit = true;
+            }
+
+        // Make sure that CPU burst time is not 0
+        if (processes[i].total_cpu_time == 0) {
+            printf("\nERROR >>> Process %d has an invalid CPU burst time of 0\n", processes[i].pid);
+            exit = true;
+        }
+
+        // Make sure that the page trace only references pages the process has
+        if (use_memory_management && (memory->mode == PAGING) && (processes[i].size_of_process >= 0) &&
+            !page_trace_fits(memory, processes[i].pid,
+                             (processes[i].size_of_process + memory->page_size - 1) / memory->page_size)) {
+            exit = true;
+        }
+    }
+    return !exit;
+}
+
+
+
+// Simulation
+
+static memory_t *new_memory(const sim_config_t *config) {
+    /*
+     * Sets up the main memory of a simulation, either from the memory_portion_sizes array or as one range that
+     * is split up as needed, depending on the memory management mode.
+     */
+
+    // At this point, the memory portion used is one of two as selected by the user
+    // This system was designed so that you only need to modify the following array to change memory for the whole program
+    int memory_portion_sizes[] = {0, 0, 0, 0};
+    if (config->memory_mode == 1) {
+        memory_portion_sizes[0] = 500;
+        memory_portion_sizes[1] = 250;
+        memory_portion_sizes[2] = 150;
+        memory_portion_sizes[3] = 100;
+    } else if (config->memory_mode == 2) {
+        memory_portion_sizes[0] = 300;
+        memory_portion_sizes[1] = 300;
+        memory_portion_sizes[2] = 350;
+        memory_portion_sizes[3] = 50;
+    }
+
+    if (config->memory_mode == 3) {
+        return new_dynamic_memory((config->memory_size > 0) ? config->memory_size : 1000, config->fit);
+    } else if (config->memory_mode == 4) {
+        return new_buddy_memory((config->memory_size > 0) ? config->memory_size : 1024);
+    } else if (config->memory_mode == 5) {
+        return new_paged_memory(config->num_frames, config->page_size, config->replacement, config->fault_time,
+                                config->access_time);
+    }
+    return new_fixed_memory(memory_portion_sizes, sizeof(memory_portion_sizes) / sizeof(int));
+}
+
+void sim_default_config(sim_config_t *config) {
+    /*
+     * Fills in the default settings: a single core running FCFS without memory management, with one I/O device.
+     * The memory and paging settings only matter once a memory management mode is picked.
+     */
+
+    config->scheduler_type = 0;
+    config->quantum = 100;
+    config->num_levels = 3;
+    for (int level = 0; level < MAX_LEVELS; level++) {
+        config->level_quanta[level] = 0;    // 0 for twice the quantum of the level above
+    }
+    config->boost_interval = 1000;
+    config->target_latency = 24;
+    config->min_granularity = 3;
+    config->burst_alpha = 0.5;
+    config->initial_burst = 10;
+    config->oracle_burst = false;
+    config->sample_interval = 0;
+    config->sample_buffer = 4096;
+    config->swapping = false;
+    config->swap_time = 10;
+    config->memory_mode = 0;
+    config->event_driven = false;
+    config->io_devices = 1;
+    config->num_cpus = 1;
+    config->fit = FIRST_FIT;
+    config->memory_size = 0;        // 0 for the default size of the memory mode
+    config->num_frames = 32;
+    config->page_size = 4;
+    config->replacement = FIFO_REPLACEMENT;
+    config->fault_time = 8;
+    config->access_time = 100;
+    config->page_trace = NULL;
+}
+
+sim_t *sim_create(const sim_config_t *config) {
+    /*
+     * Allocates a simulation with the given settings, an empty workload and no output. Returns NULL if the
+     * settings are not valid or the page trace cannot be read. The workload is given with sim_load or sim_stream, and an output with
+     * sim_set_output or sim_set_transition_callback, before the simulation runs.
+     */
+
+    if ((config->scheduler_type < 0) || (config->scheduler_type >= NUM_SCHEDULERS) || (config->memory_mode < 0) ||
+        (config->memory_mode >= NUM_MEMORY_MODES) || (config->io_devices < 0) || (config->num_cpus < 1) ||
+        (config->fit < FIRST_FIT) || (config->fit > WORST_FIT) || (config->memory_size < 0)) {
+        return NULL;
+    }
+    if ((config->memory_mode == 4) && ((config->memory_size & (config->memory_size - 1)) != 0)) {
+        return NULL;        // The buddy system splits the memory in halves down to 1 Mb
+    }
+    if ((config->memory_mode == 5) &&
+        ((config->num_frames < 1) || (config->page_size < 1) || (config->replacement < FIFO_REPLACEMENT) ||
+         (config->replacement > ARC_REPLACEMENT) || (config->fault_time < 1) || (config->access_time < 0))) {
+        return NULL;
+    }
+    if ((config->scheduler_type == 3) &&
+        ((config->quantum < 1) || (config->num_levels < 1) || (config->num_levels > MAX_LEVELS) ||
+         (config->boost_interval < 0))) {
+        return NULL;
+    }
+    if ((config->scheduler_type == 4) && ((config->target_latency < 1) || (config->min_granularity < 1))) {
+        return NULL;
+    }
+    if ((config->sample_interval < 0) || ((config->sample_interval > 0) && (config->sample_buffer < 1))) {
+        return NULL;
+    }
+    if (config->swapping && ((config->memory_mode < 1) || (config->memory_mode > 4) || (config->swap_time < 0))) {
+        return NULL;        // Paging admits every process, so only the partitioned memories swap
+    }
+    if (((config->scheduler_type == 5) || (config->scheduler_type == 6)) &&
+        ((config->burst_alpha < 0) || (config->burst_alpha > 1) || (config->initial_burst < 0))) {
+        return NULL;
+    }
+
+    sim_t *sim = calloc(1, sizeof(sim_t));
+    assert(sim != NULL);
+    sim->config = *config;
+    if ((config->scheduler_type != 2) && (config->scheduler_type != 3)) {   // The quantum is hardcoded to be 1000000
+        sim->config.quantum = 1000000;      // for all schedulers except round robin and MLFQ, so that it doesn't
+    }                                       // interfere in any other process, CFS works out its own timeslices
+    if (config->scheduler_type == 3) {      // Fill in the quanta left to default, each twice the one above
+        for (int level = 0; level < config->num_levels; level++) {
+            int quantum = config->level_quanta[level];
+            if (quantum <= 0) {
+                quantum = (level == 0) ? config->quantum : 2 * sim->config.level_quanta[level - 1];
+            }
+            sim->config.level_quanta[level] = (quantum < 1000000) ? quantum : 1000000;
+        }
+    }
+    sim->stop_time = SIM_FOREVER;
+    sim->memory = new_memory(config);
+    sim->use_memory_management = (config->memory_mode != 0);
+    sim->paging = sim->use_memory_management && (sim->memory->mode == PAGING);
+    sim->pool = new_pcb_pool(0);        // All of the pcb's are allocated in one block, sized once by sim_load,
+                                        // streamed and restored simulations grow it as needed
+
+    // Allocate an empty queue on the heap for each state in the diagram, each core has its own ready and running queue
+    sim->new = sim->use_memory_management ? new_sized_queue(sim->pool) : new_queue(sim->pool);
+    sim->ready = malloc(config->num_cpus * sizeof(queue_t *));
+    sim->running = malloc(config->num_cpus * sizeof(queue_t *));
+    assert((sim->ready != NULL) && (sim->running != NULL));
+    for (int core = 0; core < config->num_cpus; core++) {
+        if (config->scheduler_type == 1) {
+            sim->ready[core] = new_ordered_queue(sim->pool, priority_key);
+        } else if (config->scheduler_type == 3) {
+            sim->ready[core] = new_level_queue(sim->pool, config->num_levels);
+        } else if (config->scheduler_type == 4) {
+            sim->ready[core] = new_ordered_queue(sim->pool, vruntime_key);
+        } else if ((config->scheduler_type == 5) || (config->scheduler_type == 6)) {
+            sim->ready[core] = new_ordered_queue(sim->pool, burst_key);
+        } else if (config->scheduler_type == 7) {
+            sim->ready[core] = new_ordered_queue(sim->pool, deadline_key);
+        } else if (config->scheduler_type == 8) {
+            sim->ready[core] = new_ordered_queue(sim->pool, period_key);
+        } else {
+            sim->ready[core] = new_queue(sim->pool);
+        }
+        sim->running[core] = new_queue(sim->pool);
+    }
+    sim->waiting = new_ordered_queue(sim->pool, io_completion_key);
+    sim->io_backlog = new_queue(sim->pool);
+    sim->terminated = new_queue(sim->pool);
+    sim->temp = new_queue(sim->pool);
+    sim->swapped = new_queue(sim->pool);
+    sim->swapping_in = new_ordered_queue(sim->pool, io_completion_key);
+    sim->swap_root = -1;
+    sim->swap_random = 2463534242u;
+    sim->cpu_busy_time = calloc(config->num_cpus, sizeof(int));
+    assert(sim->cpu_busy_time != NULL);
+    if (config->sample_interval > 0) {
+        sim->samples = malloc(config->sample_buffer * sizeof(sim_sample_t));
+        assert(sim->samples != NULL);
+    }
+    if (sim->paging && (config->page_trace != NULL) && !load_page_trace(config->page_trace, sim->memory)) {
+        sim_destroy(sim);
+        return NULL;
+    }
+
+    return sim;
+}
+
+_Bool sim_load(sim_t *sim, const sim_process_t processes[], int num_processes) {
+    /*
+     * Gives the simulation its workload, before it starts. Every process is checked against the memory of the
+     * simulation, and the workload is not loaded if any of them is invalid, in which case false is returned. The
+     * processes can be in any order. They are not copied, so the array must outlive the simulation, but it is
+     * never written to and can be shared by several simulations running at once.
+     */
+
+    assert((sim->workload == NULL) && (sim->next_process == NULL) && (sim->time_elapsed == 0));
+
+    // Error handling function to check inputs
+    if (!error_handling(processes, num_processes, sim->memory, sim->use_memory_management)) {
+        return false;
+    }
+    sim->workload = processes;
+    sim->workload_size = num_processes;
+    sim->arrival_order = sort_by_arrival_time(processes, num_processes);
+    reserve_pcb_pool(sim->pool, num_processes);
+    return true;
+}
+
+void sim_stream(sim_t *sim, sim_next_process_t next_process, void *context) {
+    /*
+     * Makes the simulation take its processes from next_process, one at a time just before each arrives,
+     * instead of from a workload loaded up front. The processes must be given in order of arrival time. Each
+     * one is checked when it arrives, and an invalid process stops the simulation at that time: from then on
+     * sim_step and sim_run_until return false.
+     */
+
+    assert((sim->workload == NULL) && (sim->next_process == NULL) && (sim->time_elapsed == 0));
+
+    sim->next_process = next_process;
+    sim->stream_context = context;
+    sim->has_upcoming = next_process(context, &sim->upcoming);
+}
+
+void sim_set_output(sim_t *sim, FILE *output) {
+    /*
+     * Makes the simulation write its transitions and memory metrics to output, which stays open until the
+     * simulation is destroyed. The caller writes the header and the metrics at the end.
+     */
+
+    sim->output = output;
+}
+
+void sim_set_process_log(sim_t *sim, FILE *log) {
+    /*
+     * Makes the simulation write a CSV line to log with the times of each process as it terminates, after a
+     * header written now. The log stays open until the simulation is destroyed.
+     */
+
+    sim->process_log = log;
+    fprintf(log, "pid,arrival_time,admission_time,first_run_time,termination_time,turnaround_time,waiting_time,"
+                 "response_time,admission_wait\n");
+}
+
+void sim_set_sample_callback(sim_t *sim, sim_on_samples_t on_samples, void *context) {
+    /*
+     * Hands the samples to on_samples in order each time the ring buffer fills up, instead of overwriting the
+     * oldest ones. The last samples are handed over by sim_flush_samples.
+     */
+
+    sim->on_samples = on_samples;
+    sim->samples_context = context;
+}
+
+int sim_samples(const sim_t *sim, sim_sample_t samples[]) {
+    /*
+     * Copies the samples in the ring buffer to samples, oldest first, and returns how many there are. There
+     * are at most sample_buffer of them.
+     */
+
+    for (int i = 0; i < sim->num_samples; i++) {
+        samples[i] = sim->samples[(sim->sample_head + i) % sim->config.sample_buffer];
+    }
+    return sim->num_samples;
+}
+
+void sim_flush_samples(sim_t *sim) {
+    /*
+     * Hands the samples left in the ring buffer to the samples callback and empties it.
+     */
+
+    if ((sim->on_samples != NULL) && (sim->num_samples > 0)) {
+        sim->on_samples(sim->samples_context, sim->samples, sim->num_samples);
+    }
+    sim->sample_head = 0;
+    sim->num_samples = 0;
+}
+
+void sim_set_transition_callback(sim_t *sim, sim_on_transition_t on_transition, void *context) {
+    /*
+     * Hands every transition to on_transition instead of writing it to the output.
+     */
+
+    sim->on_transition = on_transition;
+    sim->transition_context = context;
+}
+
+void sim_destroy(sim_t *sim) {
+    /*
+     * Frees a simulation allocated by sim_create, with its queues, its memory and every pcb at once by freeing
+     * the pool. The workload and the output belong to the caller.
+     */
+
+    free_pcb_pool(sim->pool);
+    free_queue(sim->new);
+    for (int core = 0; core < sim->config.num_cpus; core++) {
+        free_queue(sim->ready[core]);
+        free_queue(sim->running[core]);
+    }
+    free(sim->ready);
+    free(sim->running);
+    free_queue(sim->waiting);
+    free_queue(sim->io_backlog);
+    free_queue(sim->terminated);
+    free_queue(sim->temp);
+    free_queue(sim->swapped);
+    free_queue(sim->swapping_in);
+    free(sim->swap_candidates);
+    free(sim->cpu_busy_time);
+    free(sim->samples);
+    free(sim->arrival_order);
+    free(sim->restored_workload);
+    free(sim->periodic_pids);
+    free_memory(sim->memory);
+    free(sim);
+}
+
+static _Bool add_periodic_task(sim_t *sim, int pid) {
+    /*
+     * Adds the pid of a periodic task to the set of the tasks seen so far, returns false if it already was in it.
+     * Every job of a periodic task is a line of its own sharing the pid of the task, so this is how the
+     * utilization counts each task once. The set doubles whenever it is half full.
+     */
+
+    if (2 * (sim->num_periodic + 1) > sim->periodic_capacity) {
+        int capacity = (sim->periodic_capacity == 0) ? 16 : 2 * sim->periodic_capacity;
+        long long *pids = malloc(capacity * sizeof(long long));
+        assert(pids != NULL);
+        for (int i = 0; i < capacity; i++) {
+            pids[i] = LLONG_MAX;
+        }
+        for (int i = 0; i < sim->periodic_capacity; i++) {
+            if (sim->periodic_pids[i] != LLONG_MAX) {
+                int slot = (int) ((unsigned int) sim->periodic_pids[i] & (capacity - 1));
+                while (pids[slot] != LLONG_MAX) {
+                    slot = (slot + 1) & (capacity - 1);
+                }
+                pids[slot] = sim->periodic_pids[i];
+            }
+        }
+        free(sim->periodic_pids);
+        sim->periodic_pids = pids;
+        sim->periodic_capacity = capacity;
+    }
+
+    int slot = (int) ((unsigned int) pid & (sim->periodic_capacity - 1));
+    while (sim->periodic_pids[slot] != LLONG_MAX) {
+        if (sim->periodic_pids[slot] == pid) {
+            return false;
+        }
+        slot = (slot + 1) & (sim->periodic_capacity - 1);
+    }
+    sim->periodic_pids[slot] = pid;
+    return true;
+}
+
+static void arrive(sim_t *sim, const sim_process_t *process) {
+    /*
+     * Adds a process of the workload to new. It is given its own pcb from the pool of the simulation, so the
+     * workload is never changed and can be shared by several simulations.
+     */
+
+    pcb_t *pcb = new_pcb(sim->pool, process->pid, process->arrival_time, process->total_cpu_time,
+                         process->io_frequency, process->io_duration, process->priority, process->size_of_process);
+    if (process->period > 0) {
+        pcb->period = process->period;
+        if (add_periodic_task(sim, process->pid)) {
+            sim->num_periodic++;
+            sim->periodic_utilization += (double) process->total_cpu_time / process->period;
+        }
+    }
+    if ((process->deadline > 0) || (process->period > 0)) {     // The period is the deadline if there is none
+        pcb->deadline = (long long) process->arrival_time + ((process->deadline > 0) ? process->deadline
+                                                                                      : process->period);
+    }
+    sim->total_cpu_burst_time += pcb->remaining_cpu_time;
+    sim->num_processes++;
+    enqueue(sim->new, pcb);
+}
+
+static void add_arrivals(sim_t *sim) {
+    /*
+     * Adds every process that arrives at the current time to new. Stops at an invalid streamed process.
+     */
+
+    if (sim->next_process == NULL) {
+        while ((sim->next_arrival < sim->workload_size) &&
+               (workload_process(sim, sim->next_arrival)->arrival_time <= sim->time_elapsed)) {
+            arrive(sim, workload_process(sim, sim->next_arrival));
+            sim->next_arrival++;
+        }
+        return;
+    }
+
+    while (sim->has_upcoming && (sim->upcoming.arrival_time <= sim->time_elapsed)) {
+        if (!error_handling(&sim->upcoming, 1, sim->memory, sim->use_memory_management)) {
+            sim->stream_failed = true;
+            return;
+        }
+        arrive(sim, &sim->upcoming);
+        sim->has_upcoming = sim->next_process(sim->stream_context, &sim->upcoming);
+    }
+}
+
+_Bool sim_finished(const sim_t *sim) {
+    /*
+     * Returns true once every process has arrived and terminated.
+     */
+
+    return (sim->num_terminated == sim->num_processes) && (next_arrival_time(sim) == -1);
+}
+
+static void step(sim_t *sim) {
+    /*
+     * Simulates one tick, or in event-driven mode every tick up to the next event, and moves the clock on. The
+     * jump to the next event stops at the stop time, so that sim_run_until never runs past the time it is given.
+     */
+
+    int num_cpus = sim->config.num_cpus;
+    queue_t *new = sim->new;
+    queue_t **ready = sim->ready;
+    queue_t **running = sim->running;
+    pcb_t *curr;
+
+    sim->memory_freed = false;
+
+    // Metrics calculations
+    sim->total_waiting_time += count_ready(ready, num_cpus);
+    if (sim->waiting->size + sim->io_backlog->size == 0) { sim->total_time_between_io++; }
+    if (sim->config.sample_interval > 0) {
+        take_samples(sim);
+    }
+
+    // Give every process back the top MLFQ level at each priority boost
+    if ((sim->config.scheduler_type == 3) && (sim->config.boost_interval > 0) && (sim->time_elapsed > 0) &&
+        (sim->time_elapsed % sim->config.boost_interval == 0)) {
+        boost_priorities(sim);
+    }
+
+    // Add processes to new at their arrival time, nothing else is simulated once an invalid one arrives
+    add_arrivals(sim);
+    if (sim->stream_failed) {
+        return;
+    }
+
+    // Move processes from new to ready (admit processes), option to use memory management or not. Swapped out
+    // processes get their memory back before any new process is admitted.
+    if (sim->use_memory_management) {
+        if (sim->config.swapping) {
+            swap_in(sim);
+        }
+        // Admit the processes in order of arrival that fit, new being indexed by the size of the processes
+        if (memory_has_free_space(sim->memory)) {
+            while (((curr = first_fitting(new, largest_allocation(sim->memory))) != NULL) &&
+                   allocate_memory(curr, sim->memory, sim->output)) {
+                if (curr == queue_front(new)) {
+                    scheduler(0, new, least_loaded_ready_queue(ready, running, num_cpus), sim);
+                } else {
+                    remove_from_sized_queue(new, curr);
+                    enqueue(sim->temp, curr);
+                    scheduler(0, sim->temp, least_loaded_ready_queue(ready, running, num_cpus), sim);
+                }
+            }
+        }
+        if (sim->config.swapping) {
+            swap_out(sim);
+        }
+    } else {       // This else statement is used if memory management is not to be used
+        while (new->size != 0) {
+            scheduler(0, new, least_loaded_ready_queue(ready, running, num_cpus), sim);
+        }
+    }
+
+    // Each core dispatches and runs its own process
+    for (int core = 0; core < num_cpus; core++) {
+
+        // If the core is idle and has nothing ready, take a process from the busiest ready queue
+        if ((running[core]->size == 0) && (ready[core]->size == 0)) {
+            steal_work(ready, core, num_cpus);
+        }
+
+        // If there is a process in ready and running is empty, transition
+        if ((ready[core]->size > 0) && (running[core]->size == 0)) {
+            transition(1, ready[core], running[core], sim);
+            queue_front(running[core])->cpu_arrival_time = sim->time_elapsed;
+        }
+
+        // If there is a process in running, check if it needs to transition and update its
+        // remaining CPU time.
+        if (running[core]->size > 0) {
+
+            // If the process in running is done executing, move it from running to terminated
+            if (queue_front(running[core])->remaining_cpu_time == 0) {
+                sim->total_turnaround_time += sim->time_elapsed - queue_front(running[core])->arrival_time;
+                record_process(sim, queue_front(running[core]));
+                transition(5, running[core], sim->terminated, sim);
+                if (sim->use_memory_management) {
+                    deallocate_memory(queue_front(sim->terminated), sim->memory);
+                    sim->memory_freed = true;
+                }
+                dequeue(sim->terminated, true);     // Give the pcb back to the pool
+                sim->num_terminated++;
+
+            // If the process in running needs I/O, transition from running to waiting
+            } else if (queue_front(running[core])->time_until_io == 0) {
+                sim->num_io++;
+                queue_front(running[core])->time_until_io = queue_front(running[core])->io_frequency;
+                start_io(sim, running[core], queue_front(running[core])->io_duration);
+
+            // If an interrupt is triggered because a process has been in running for too long,
+            // transition to ready.
+            } else if ((sim->time_elapsed - queue_front(running[core])->cpu_arrival_time) >
+                       process_quantum(sim, core) || should_preempt(sim, core))  {
+                scheduler(4, running[core], ready[core], sim);
+
+            // If the page the process references is not in a frame, the process waits for an I/O
+            // device to read it in.
+            } else if (sim->paging && !reference_page(sim->memory, queue_front(running[core]))) {
+                start_io(sim, running[core], sim->memory->fault_time);
+            } else {
+                queue_front(running[core])->remaining_cpu_time -= 1;
+                queue_front(running[core])->time_until_io -= 1;
+                sim->cpu_busy_time[core]++;
+            }
+        }
+    }
+
+    // If there are processes in waiting that are done, transition them to ready and
+    // start the I/O of the processes waiting for a free device.
+    complete_io(sim);
+    complete_swap_in(sim);
+
+    // In event-driven mode, apply the ticks where nothing happens in bulk and jump to the tick before the next event
+    if (sim->config.event_driven && !sim_finished(sim)) {
+        int next_event = next_event_time(sim);
+        if ((sim->stop_time != SIM_FOREVER) && (next_event > sim->stop_time)) {
+            next_event = sim->stop_time;
+        }
+        int skipped_ticks = next_event - sim->time_elapsed - 1;
+        if (skipped_ticks > 0) {
+            sim->total_waiting_time += count_ready(ready, num_cpus) * skipped_ticks;
+            if (sim->waiting->size + sim->io_backlog->size == 0) { sim->total_time_between_io += skipped_ticks; }
+            for (int core = 0; core < num_cpus; core++) {
+                if (running[core]->size > 0) {
+                    queue_front(running[core])->remaining_cpu_time -= skipped_ticks;
+                    queue_front(running[core])->time_until_io -= skipped_ticks;
+                    sim->cpu_busy_time[core] += skipped_ticks;
+                }
+            }
+            sim->time_elapsed += skipped_ticks;
+        }
+    }
+    sim->time_elapsed++;
+}
+
+_Bool sim_step(sim_t *sim) {
+    /*
+     * Simulates one tick, or in event-driven mode every tick up to the next event. Returns false, without
+     * simulating anything, once the simulation has finished or was stopped by an invalid streamed process.
+     */
+
+    if (sim->stream_failed || sim_finished(sim)) {
+        return false;
+    }
+    step(sim);
+    return true;
+}
+
+_Bool sim_run_until(sim_t *sim, int time) {
+    /*
+     * Runs the simulation until its clock reaches time, or until every process has terminated if time is
+     * SIM_FOREVER. Returns true once the simulation has finished, false if it has not finished yet or an
+     * invalid streamed process stopped it. It can be run again up to a later time, and comes out the same as
+     * if it had run there at once.
+     */
+
+    sim->stop_time = time;
+    while (((time == SIM_FOREVER) || (sim->time_elapsed < time)) && sim_step(sim)) {
+    }
+    sim->stop_time = SIM_FOREVER;
+    return !sim->stream_failed && sim_finished(sim);
+}
+
+sim_metrics_t sim_metrics(const sim_t *sim) {
+    /*
+     * Returns the metrics of the simulation so far, which are final once it has finished.
+     */
+
+    sim_metrics_t metrics;
+    metrics.time_elapsed = sim->time_elapsed;
+    metrics.num_processes = sim->num_processes;
+    metrics.num_terminated = sim->num_terminated;
+    metrics.total_cpu_burst_time = sim->total_cpu_burst_time;
+    metrics.total_turnaround_time = sim->total_turnaround_time;
+    metrics.total_waiting_time = sim->total_waiting_time;
+    metrics.total_time_between_io = sim->total_time_between_io;
+    metrics.num_io = sim->num_io;
+    metrics.num_transitions = sim->num_transitions;
+    metrics.num_cpus = sim->config.num_cpus;
+    metrics.cpu_busy_time = sim->cpu_busy_time;
+    metrics.paging = sim->paging;
+    metrics.page_references = sim->memory->page_references;
+    metrics.page_faults = sim->memory->page_faults;
+    metrics.swapping = sim->config.swapping;
+    metrics.num_swap_outs = sim->num_swap_outs;
+    metrics.num_swap_ins = sim->num_swap_ins;
+    metrics.swap_traffic = sim->swap_traffic;
+    metrics.turnaround_time = time_percentiles(&sim->turnaround_times);
+    metrics.waiting_time = time_percentiles(&sim->waiting_times);
+    metrics.response_time = time_percentiles(&sim->response_times);
+    metrics.admission_time = time_percentiles(&sim->admission_times);
+    metrics.num_deadlines = sim->num_deadlines;
+    metrics.num_missed_deadlines = sim->num_missed_deadlines;
+    metrics.lateness = time_percentiles(&sim->lateness_times);
+    metrics.num_periodic = sim->num_periodic;
+    metrics.periodic_utilization = sim->periodic_utilization;
+    return metrics;
+}
+
+
+
+// Snapshots
+
+static void write_snapshot_int(FILE *file, long long value) {
+    /*
+     * Writes a value to a snapshot in 1 to 10 bytes. The value is zigzag encoded so that small negative values
+     * are short too, then written seven bits per byte, with the top bit set on every byte but the last.
+     */
+
+    unsigned long long zigzag = ((unsigned long long) value << 1) ^ (unsigned long long) -(value < 0);
+    while (zigzag >= 0x80) {
+        fputc((int) ((zigzag & 0x7f) | 0x80), file);
+        zigzag >>= 7;
+    }
+    fputc((int) zigzag, file);
+}
+
+static long long read_snapshot_int(snapshot_reader_t *reader) {
+    /*
+     * Reads a value written by write_snapshot_int, 0 if the snapshot ends first.
+     */
+
+    unsigned long long zigzag = 0;
+    int shift = 0;
+    int byte;
+    do {
+        byte = fgetc(reader->file);
+        if ((byte == EOF) || (shift > 63)) {
+            reader->failed = true;
+            return 0;
+        }
+        zigzag |= (unsigned long long) (byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return (long long) (zigzag >> 1) ^ -(long long) (zigzag & 1);
+}
+
+static int read_snapshot_range(snapshot_reader_t *reader, int low, int high) {
+    /*
+     * Reads a count or an index, which has to be from low to high. The snapshot fails on any other value, and
+     * low is returned instead so that the value can still be used safely.
+     */
+
+    long long value = read_snapshot_int(reader);
+    if ((value < low) || (value > high)) {
+        reader->failed = true;
+        return low;
+    }
+    return (int) value;
+}
+
+static void write_snapshot_double(FILE *file, double value) {
+    /*
+     * Writes the eight bytes of a double, least significant byte first.
+     */
+
+    unsigned long long bits;
+    memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 8; i++) {
+        fputc((int) ((bits >> (8 * i)) & 0xff), file);
+    }
+}
+
+static double read_snapshot_double(snapshot_reader_t *reader) {
+    /*
+     * Reads a double written by write_snapshot_double, 0 if the snapshot ends first.
+     */
+
+    unsigned long long bits = 0;
+    for (int i = 0; i < 8; i++) {
+        int byte = fgetc(reader->file);
+        if (byte == EOF) {
+            reader->failed = true;
+            return 0;
+        }
+        bits |= (unsigned long long) byte << (8 * i);
+    }
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void write_snapshot_histogram(FILE *file, const histogram_t *histogram) {
+    /*
+     * Writes the buckets of a histogram that hold times, each as its index and its count, then the totals.
+     * Most of the buckets of a histogram are empty, so they are left out.
+     */
+
+    int num_buckets = 0;
+    for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        num_buckets += (histogram->counts[bucket] != 0);
+    }
+    write_snapshot_int(file, num_buckets);
+    for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        if (histogram->counts[bucket] != 0) {
+            write_snapshot_int(file, bucket);
+            write_snapshot_int(file, histogram->counts[bucket]);
+        }
+    }
+    write_snapshot_int(file, histogram->count);
+    write_snapshot_int(file, histogram->max);
+}
+
+static void read_snapshot_histogram(snapshot_reader_t *reader, histogram_t *histogram) {
+    /*
+     * Reads a histogram written by write_snapshot_histogram into an empty one.
+     */
+
+    int num_buckets = read_snapshot_range(reader, 0, HISTOGRAM_BUCKETS);
+    for (int i = 0; i < num_buckets; i++) {
+        int bucket = read_snapshot_range(reader, 0, HISTOGRAM_BUCKETS - 1);
+        histogram->counts[bucket] = read_snapshot_int(reader);
+    }
+    histogram->count = read_snapshot_int(reader);
+    histogram->max = (int) read_snapshot_int(reader);
+}
+
+static int snapshot_queues(const sim_t *sim, queue_t *queues[]) {
+    /*
+     * Fills queues with every queue that can hold pcbs between two ticks, in the order a snapshot lists them,
+     * and returns how many there are, 2 per core and 5 more. Terminated and temp are always empty by then.
+     */
+
+    int num_queues = 0;
+    queues[num_queues++] = sim->new;
+    for (int core = 0; core < sim->config.num_cpus; core++) {
+        queues[num_queues++] = sim->ready[core];
+    }
+    for (int core = 0; core < sim->config.num_cpus; core++) {
+        queues[num_queues++] = sim->running[core];
+    }
+    queues[num_queues++] = sim->waiting;
+    queues[num_queues++] = sim->io_backlog;
+    queues[num_queues++] = sim->swapped;
+    queues[num_queues++] = sim->swapping_in;
+    return num_queues;
+}
+
+static int compare_heap_entries(const void *a, const void *b) {
+    /*
+     * Orders the entries of an ordered queue the way they are dequeued.
+     */
+
+    heap_entry_t *x = (heap_entry_t *) a;
+    heap_entry_t *y = (heap_entry_t *) b;
+    return heap_entry_less(x, y) ? -1 : heap_entry_less(y, x);
+}
+
+static int *queue_order(queue_t *queue) {
+    /*
+     * Returns the pool indices of the pcbs of a queue in the order they would be dequeued in, each level in turn
+     * from the top for a multilevel queue. Enqueueing them in this order into an empty queue of the same kind
+     * gives back the same queue, since the keys of the pcbs do not change while they are queued.
+     */
+
+    int *order = malloc((queue->size > 0 ? queue->size : 1) * sizeof(int));
+    assert(order != NULL);
+    int num_pcbs = 0;
+    if (queue->key != NULL) {
+        heap_entry_t *entries = malloc((queue->size > 0 ? queue->size : 1) * sizeof(heap_entry_t));
+        assert(entries != NULL);
+        for (int i = 0; i < queue->size; i++) {
+            entries[i] = queue->heap[i];
+        }
+        qsort(entries, queue->size, sizeof(heap_entry_t), compare_heap_entries);
+        for (int i = 0; i < queue->size; i++) {
+            order[num_pcbs++] = entries[i].pcb;
+        }
+        free(entries);
+    } else if (queue->num_levels > 0) {
+        for (int level = 0; level < queue->num_levels; level++) {
+            for (int index = queue->level_front[level]; index != -1; index = queue->pool->pcbs[index].next) {
+                order[num_pcbs++] = index;
+            }
+        }
+    } else {
+        for (pcb_t *pcb = queue_front(queue); pcb != NULL; pcb = queue_next(queue, pcb)) {
+            order[num_pcbs++] = (int) (pcb - queue->pool->pcbs);
+        }
+    }
+    return order;
+}
+
+static void write_snapshot_pcb(FILE *file, const pcb_t *pcb) {
+    /*
+     * Writes every field of a pcb but its links, which are rebuilt by enqueueing it again. The page table is
+     * written as the page node of each page.
+     */
+
+    write_snapshot_int(file, pcb->pid);
+    write_snapshot_int(file, pcb->arrival_time);
+    write_snapshot_int(file, pcb->remaining_cpu_time);
+    write_snapshot_int(file, pcb->cpu_arrival_time);
+    write_snapshot_int(file, pcb->io_frequency);
+    write_snapshot_int(file, pcb->io_duration);
+    write_snapshot_int(file, pcb->time_until_io);
+    write_snapshot_int(file, pcb->priority);
+    write_snapshot_int(file, pcb->size_of_process);
+    write_snapshot_int(file, pcb->base_memory_location);
+    write_snapshot_int(file, pcb->io_completion_time);
+    write_snapshot_int(file, pcb->io_service_time);
+    write_snapshot_int(file, pcb->level);
+    write_snapshot_int(file, pcb->weight);
+    write_snapshot_int(file, pcb->vruntime);
+    write_snapshot_int(file, pcb->charged_cpu_time);
+    write_snapshot_double(file, pcb->predicted_burst);
+    write_snapshot_int(file, pcb->burst_start_cpu_time);
+    write_snapshot_int(file, pcb->expected_burst);
+    write_snapshot_int(file, pcb->state_entered_time);
+    write_snapshot_int(file, pcb->admission_time);
+    write_snapshot_int(file, pcb->first_run_time);
+    write_snapshot_int(file, pcb->waiting_time);
+    write_snapshot_int(file, pcb->deadline);
+    write_snapshot_int(file, pcb->period);
+    write_snapshot_int(file, pcb->swapped_out);
+    write_snapshot_int(file, pcb->swap_out_done);
+    write_snapshot_int(file, pcb->num_pages);
+    for (int page = 0; page < pcb->num_pages; page++) {
+        write_snapshot_int(file, pcb->page_table[page]);
+    }
+    write_snapshot_int(file, pcb->next_page);
+    write_snapshot_int(file, pcb->page_read_in);
+    write_snapshot_int(file, pcb->locality_base);
+    write_snapshot_int(file, pcb->reference_state);
+    write_snapshot_int(file, pcb->trace_start);
+    write_snapshot_int(file, pcb->trace_length);
+    write_snapshot_int(file, pcb->trace_position);
+}
+
+static void read_snapshot_pcb(snapshot_reader_t *reader, pcb_pool_t *pool) {
+    /*
+     * Reads a pcb written by write_snapshot_pcb into a new pcb of the pool.
+     */
+
+    pcb_t *pcb = new_pcb(pool, 0, 0, 1, 0, 0, 0, 0);
+    pcb->pid = (int) read_snapshot_int(reader);
+    pcb->arrival_time = (int) read_snapshot_int(reader);
+    pcb->remaining_cpu_time = (int) read_snapshot_int(reader);
+    pcb->cpu_arrival_time = (int) read_snapshot_int(reader);
+    pcb->io_frequency = (int) read_snapshot_int(reader);
+    pcb->io_duration = (int) read_snapshot_int(reader);
+    pcb->time_until_io = (int) read_snapshot_int(reader);
+    pcb->priority = (int) read_snapshot_int(reader);
+    pcb->size_of_process = read_snapshot_range(reader, 0, INT_MAX);
+    pcb->base_memory_location = (int) read_snapshot_int(reader);
+    pcb->io_completion_time = (int) read_snapshot_int(reader);
+    pcb->io_service_time = (int) read_snapshot_int(reader);
+    pcb->level = read_snapshot_range(reader, 0, MAX_LEVELS - 1);
+    pcb->weight = read_snapshot_range(reader, 1, INT_MAX);
+    pcb->vruntime = read_snapshot_int(reader);
+    pcb->charged_cpu_time = (int) read_snapshot_int(reader);
+    pcb->predicted_burst = read_snapshot_double(reader);
+    pcb->burst_start_cpu_time = (int) read_snapshot_int(reader);
+    pcb->expected_burst = (int) read_snapshot_int(reader);
+    pcb->state_entered_time = (int) read_snapshot_int(reader);
+    pcb->admission_time = (int) read_snapshot_int(reader);
+    pcb->first_run_time = (int) read_snapshot_int(reader);
+    pcb->waiting_time = (int) read_snapshot_int(reader);
+    pcb->deadline = read_snapshot_int(reader);
+    pcb->period = read_snapshot_int(reader);
+    pcb->swapped_out = read_snapshot_range(reader, 0, 1);
+    pcb->swap_out_done = (int) read_snapshot_int(reader);
+    pcb->num_pages = read_snapshot_range(reader, 0, pcb->size_of_process);
+    if (pcb->num_pages > 0) {
+        pcb->page_table = malloc(pcb->num_pages * sizeof(int));
+        assert(pcb->page_table != NULL);
+        for (int page = 0; page < pcb->num_pages; page++) {
+            pcb->page_table[page] = read_snapshot_range(reader, -1, INT_MAX);
+        }
+    }
+    pcb->next_page = read_snapshot_range(reader, 0, (pcb->num_pages > 0) ? pcb->num_pages - 1 : 0);
+    pcb->page_read_in = read_snapshot_range(reader, 0, 1);
+    pcb->locality_base = (int) read_snapshot_int(reader);
+    pcb->reference_state = (unsigned int) read_snapshot_int(reader);
+    pcb->trace_start = (int) read_snapshot_int(reader);
+    pcb->trace_length = (int) read_snapshot_int(reader);
+    pcb->trace_position = (int) read_snapshot_int(reader);
+}
+
+static void write_snapshot_memory(FILE *file, const sim_t *sim, const int number[]) {
+    /*
+     * Writes the layout of the memory, then its state. A page node refers to the pcb whose page it holds by
+     * the number the pcb was written with, -1 for a free node.
+     */
+
+    memory_t *memory = sim->memory;
+    write_snapshot_int(file, sim->use_memory_management);
+    if (!sim->use_memory_management) {
+        return;
+    }
+    write_snapshot_int(file, memory->mode);
+    write_snapshot_int(file, memory->total_size);
+    if (memory->mode == FIXED_PARTITIONS) {
+        write_snapshot_int(file, memory->num_portions);
+        for (int i = 0; i < memory->num_portions; i++) {
+            write_snapshot_int(file, memory->portions[i][0]);
+        }
+    } else if (memory->mode == PAGING) {
+        write_snapshot_int(file, memory->num_frames);
+        write_snapshot_int(file, memory->page_size);
+        write_snapshot_int(file, memory->replacement);
+    }
+
+    write_snapshot_int(file, memory->num_allocated);
+    if (memory->mode == FIXED_PARTITIONS) {
+        for (int i = 0; i < memory->num_portions; i++) {
+            write_snapshot_int(file, memory->portions[i][1]);
+        }
+        write_snapshot_int(file, memory->num_used_portions);
+        write_snapshot_int(file, memory->used_memory);
+        write_snapshot_int(file, memory->free_memory);
+    } else if (memory->mode == DYNAMIC_PARTITIONS) {
+        write_snapshot_int(file, memory->num_hole_nodes);
+        for (int node = 0; node < memory->num_hole_nodes; node++) {
+            hole_t *hole = &memory->holes[node];
+            write_snapshot_int(file, hole->address);
+            write_snapshot_int(file, hole->size);
+            write_snapshot_int(file, hole->priority);
+            write_snapshot_int(file, hole->left[0]);
+            write_snapshot_int(file, hole->left[1]);
+            write_snapshot_int(file, hole->right[0]);
+            write_snapshot_int(file, hole->right[1]);
+            write_snapshot_int(file, hole->max_size);
+        }
+        write_snapshot_int(file, memory->free_hole);
+        write_snapshot_int(file, memory->root[0]);
+        write_snapshot_int(file, memory->root[1]);
+        write_snapshot_int(file, memory->num_holes);
+        write_snapshot_int(file, memory->free_memory);
+        write_snapshot_int(file, memory->next_fit_address);
+        write_snapshot_int(file, memory->random_state);
+    } else if (memory->mode == BUDDY_SYSTEM) {
+        for (int order = 0; order <= memory->max_order; order++) {
+            write_snapshot_int(file, memory->free_blocks[order]);
+        }
+        write_snapshot_int(file, memory->num_free_blocks);
+        for (int address = 0; address < memory->total_size; address++) {
+            if (memory->block_order[address] != -1) {
+                write_snapshot_int(file, address);
+                write_snapshot_int(file, memory->block_order[address]);
+                write_snapshot_int(file, memory->next_block[address]);
+                write_snapshot_int(file, memory->prev_block[address]);
+            }
+        }
+        write_snapshot_int(file, memory->free_memory);
+        write_snapshot_int(file, memory->used_memory);
+        write_snapshot_int(file, memory->internal_fragmentation);
+    } else {
+        // The pcbs know which page node holds each of their pages, which tells the owner of each node
+        int num_nodes = 2 * memory->num_frames;
+        int *owner = malloc(num_nodes * sizeof(int));
+        assert(owner != NULL);
+        for (int node = 0; node < num_nodes; node++) {
+            owner[node] = -1;
+        }
+        for (int index = 0; index < sim->pool->size; index++) {
+            pcb_t *pcb = &sim->pool->pcbs[index];
+            for (int page = 0; (number[index] != -1) && (page < pcb->num_pages); page++) {
+                if (pcb->page_table[page] != -1) {
+                    owner[pcb->page_table[page]] = number[index];
+                }
+            }
+        }
+        for (int node = 0; node < num_nodes; node++) {
+            page_node_t *page = &memory->page_nodes[node];
+            write_snapshot_int(file, owner[node]);
+            if (owner[node] != -1) {
+                write_snapshot_int(file, page->page);
+                write_snapshot_int(file, page->frame);
+                write_snapshot_int(file, page->list);
+                write_snapshot_int(file, page->prev);
+                write_snapshot_int(file, page->referenced);
+            }
+            write_snapshot_int(file, page->next);
+        }
+        free(owner);
+        write_snapshot_int(file, memory->free_page_node);
+        for (int frame = 0; frame < memory->num_frames; frame++) {
+            write_snapshot_int(file, memory->frame_page[frame]);
+        }
+        write_snapshot_int(file, memory->num_free_frames);
+        for (int i = 0; i < memory->num_free_frames; i++) {
+            write_snapshot_int(file, memory->free_frames[i]);
+        }
+        for (int list = 0; list < 4; list++) {
+            write_snapshot_int(file, memory->list_front[list]);
+            write_snapshot_int(file, memory->list_rear[list]);
+            write_snapshot_int(file, memory->list_size[list]);
+        }
+        write_snapshot_int(file, memory->arc_target);
+        write_snapshot_int(file, memory->clock_hand);
+    }
+}
+
+static _Bool read_snapshot_memory(snapshot_reader_t *reader, sim_t *sim, int num_pcbs) {
+    /*
+     * Reads the memory written by write_snapshot_memory into the empty memory of the simulation, and links the
+     * page nodes to the page tables of the first num_pcbs pcbs of the pool. Returns false, without reading the
+     * state, if the memory of the simulation does not have the layout of the saved one.
+     */
+
+    memory_t *memory = sim->memory;
+    _Bool same_layout = (read_snapshot_range(reader, 0, 1) == sim->use_memory_management);
+    if (!same_layout || !sim->use_memory_management) {
+        return same_layout;
+    }
+    same_layout = (read_snapshot_int(reader) == memory->mode) && (read_snapshot_int(reader) == memory->total_size);
+    if (same_layout && (memory->mode == FIXED_PARTITIONS)) {
+        same_layout = (read_snapshot_int(reader) == memory->num_portions);
+        for (int i = 0; same_layout && (i < memory->num_portions); i++) {
+            same_layout = (read_snapshot_int(reader) == memory->portions[i][0]);
+        }
+    } else if (same_layout && (memory->mode == PAGING)) {
+        same_layout = (read_snapshot_int(reader) == memory->num_frames) &&
+                      (read_snapshot_int(reader) == memory->page_size) &&
+                      (read_snapshot_int(reader) == memory->replacement);
+    }
+    if (!same_layout) {
+        return false;
+    }
+
+    memory->num_allocated = read_snapshot_range(reader, 0, num_pcbs);
+    if (memory->mode == FIXED_PARTITIONS) {
+        for (int i = 0; i < memory->num_portions; i++) {
+            memory->portions[i][1] = read_snapshot_range(reader, 0, memory->portions[i][0]);
+        }
+        memory->num_used_portions = read_snapshot_range(reader, 0, memory->num_portions);
+        memory->used_memory = (int) read_snapshot_int(reader);
+        memory->free_memory = (int) read_snapshot_int(reader);
+    } else if (memory->mode == DYNAMIC_PARTITIONS) {
+        // Holes never overlap, so there were never more of them than Mb
+        int num_nodes = read_snapshot_range(reader, 0, memory->total_size + 1);
+        if (num_nodes > memory->holes_capacity) {
+            memory->holes_capacity = num_nodes;
+            memory->holes = realloc(memory->holes, memory->holes_capacity * sizeof(hole_t));
+            assert(memory->holes != NULL);
+        }
+        memory->num_hole_nodes = num_nodes;
+        for (int node = 0; node < num_nodes; node++) {
+            hole_t *hole = &memory->holes[node];
+            hole->address = read_snapshot_range(reader, 0, memory->total_size);
+            hole->size = read_snapshot_range(reader, 0, memory->total_size);
+            hole->priority = (unsigned int) read_snapshot_int(reader);
+            hole->left[0] = read_snapshot_range(reader, -1, num_nodes - 1);
+            hole->left[1] = read_snapshot_range(reader, -1, num_nodes - 1);
+            hole->right[0] = read_snapshot_range(reader, -1, num_nodes - 1);
+            hole->right[1] = read_snapshot_range(reader, -1, num_nodes - 1);
+            hole->max_size = read_snapshot_range(reader, 0, memory->total_size);
+        }
+        memory->free_hole = read_snapshot_range(reader, -1, num_nodes - 1);
+        memory->root[0] = read_snapshot_range(reader, -1, num_nodes - 1);
+        memory->root[1] = read_snapshot_range(reader, -1, num_nodes - 1);
+        memory->num_holes = read_snapshot_range(reader, 0, num_nodes);
+        memory->free_memory = read_snapshot_range(reader, 0, memory->total_size);
+        memory->next_fit_address = (int) read_snapshot_int(reader);
+        memory->random_state = (unsigned int) read_snapshot_int(reader);
+    } else if (memory->mode == BUDDY_SYSTEM) {
+        int size = memory->total_size;
+        for (int order = 0; order <= memory->max_order; order++) {
+            memory->free_blocks[order] = read_snapshot_range(reader, -1, size - 1);
+        }
+        memory->num_free_blocks = read_snapshot_range(reader, 0, size);
+        memory->block_order[0] = -1;        // The whole memory was one free block when it was made
+        for (int i = 0; i < memory->num_free_blocks; i++) {
+            int address = read_snapshot_range(reader, 0, size - 1);
+            memory->block_order[address] = read_snapshot_range(reader, 0, memory->max_order);
+            memory->next_block[address] = read_snapshot_range(reader, -1, size - 1);
+            memory->prev_block[address] = read_snapshot_range(reader, -1, size - 1);
+        }
+        memory->free_memory = read_snapshot_range(reader, 0, size);
+        memory->used_memory = read_snapshot_range(reader, 0, size);
+        memory->internal_fragmentation = read_snapshot_range(reader, 0, size);
+    } else {
+        int num_nodes = 2 * memory->num_frames;
+        for (int node = 0; node < num_nodes; node++) {
+            page_node_t *page = &memory->page_nodes[node];
+            int owner = read_snapshot_range(reader, -1, num_pcbs - 1);
+            if (owner != -1) {
+                pcb_t *pcb = &sim->pool->pcbs[owner];
+                page->page_table = pcb->page_table;
+                page->page = read_snapshot_range(reader, 0, (pcb->num_pages > 0) ? pcb->num_pages - 1 : 0);
+                page->frame = read_snapshot_range(reader, -1, memory->num_frames - 1);
+                page->list = read_snapshot_range(reader, 0, 3);
+                page->prev = read_snapshot_range(reader, -1, num_nodes - 1);
+                page->referenced = read_snapshot_range(reader, 0, 1);
+                if ((pcb->num_pages == 0) || (pcb->page_table[page->page] != node)) {
+                    reader->failed = true;
+                }
+            }
+            page->next = read_snapshot_range(reader, -1, num_nodes - 1);
+        }
+        memory->free_page_node = read_snapshot_range(reader, -1, num_nodes - 1);
+        for (int frame = 0; frame < memory->num_frames; frame++) {
+            memory->frame_page[frame] = read_snapshot_range(reader, -1, num_nodes - 1);
+        }
+        memory->num_free_frames = read_snapshot_range(reader, 0, memory->num_frames);
+        for (int i = 0; i < memory->num_free_frames; i++) {
+            memory->free_frames[i] = read_snapshot_range(reader, 0, memory->num_frames - 1);
+        }
+        for (int list = 0; list < 4; list++) {
+            memory->list_front[list] = read_snapshot_range(reader, -1, num_nodes - 1);
+            memory->list_rear[list] = read_snapshot_range(reader, -1, num_nodes - 1);
+            memory->list_size[list] = read_snapshot_range(reader, 0, num_nodes);
+        }
+        memory->arc_target = read_snapshot_range(reader, 0, memory->num_frames);
+        memory->clock_hand = read_snapshot_range(reader, 0, memory->num_frames - 1);
+
+        // Every page table entry has to be a node, and the page trace is the one given with the settings
+        for (int index = 0; index < num_pcbs; index++) {
+            pcb_t *pcb = &sim->pool->pcbs[index];
+            for (int page = 0; page < pcb->num_pages; page++) {
+                if (pcb->page_table[page] >= num_nodes) {
+                    reader->failed = true;
+                    pcb->page_table[page] = -1;
+                }
+            }
+            if ((pcb->num_pages > 0) && !reader->failed) {
+                int position = pcb->trace_position;
+                find_page_trace(memory, pcb);
+                pcb->trace_position = (pcb->trace_length > 0) ? position % pcb->trace_length : 0;
+            }
+        }
+    }
+    return true;
+}
+
+_Bool sim_save(const sim_t *sim, FILE *file) {
+    /*
+     * Writes the whole state of the simulation to file, as a snapshot that sim_restore turns back into a
+     * simulation going on from the same point. Returns false if the file could not be written, or if the
+     * simulation is streamed, since the processes still to come are then not the simulation's to save. A
+     * snapshot holds, in order:
+     * - a 16 byte header: the magic, the version as a 32 bit integer and the time as a 64 bit integer
+     * - the settings the pcbs depend on and every metric so far
+     * - the processes of the workload that have not arrived yet
+     * - the pcbs of each queue in the order they would be dequeued in
+     * - the layout and the state of the memory
+     * Every value after the header is a zigzag varint, but doubles, which take eight bytes. Integers in the
+     * header are little-endian. The transitions, samples and process log written so far are output rather than
+     * state, so they are not part of it.
+     */
+
+    if (sim->next_process != NULL) {
+        return false;
+    }
+
+    unsigned char header[SNAPSHOT_HEADER_SIZE] = {0};
+    memcpy(header, SIM_SNAPSHOT_MAGIC, 4);
+    for (int i = 0; i < 4; i++) {
+        header[4 + i] = (SNAPSHOT_VERSION >> (8 * i)) & 0xff;
+        header[8 + i] = ((unsigned int) sim->time_elapsed >> (8 * i)) & 0xff;
+    }
+    fwrite(header, 1, sizeof(header), file);
+
+    // Settings and metrics
+    write_snapshot_int(file, sim->config.scheduler_type);
+    write_snapshot_int(file, sim->config.oracle_burst);
+    write_snapshot_int(file, sim->config.num_cpus);
+    write_snapshot_int(file, sim->min_vruntime);
+    write_snapshot_int(file, sim->num_processes);
+    write_snapshot_int(file, sim->num_terminated);
+    write_snapshot_int(file, sim->total_cpu_burst_time);
+    write_snapshot_int(file, sim->total_turnaround_time);
+    write_snapshot_int(file, sim->total_waiting_time);
+    write_snapshot_int(file, sim->total_time_between_io);
+    write_snapshot_int(file, sim->num_io);
+    write_snapshot_int(file, sim->num_transitions);
+    for (int core = 0; core < sim->config.num_cpus; core++) {
+        write_snapshot_int(file, sim->cpu_busy_time[core]);
+    }
+    write_snapshot_int(file, sim->num_swap_outs);
+    write_snapshot_int(file, sim->num_swap_ins);
+    write_snapshot_int(file, sim->swap_traffic);
+    write_snapshot_histogram(file, &sim->turnaround_times);
+    write_snapshot_histogram(file, &sim->waiting_times);
+    write_snapshot_histogram(file, &sim->response_times);
+    write_snapshot_histogram(file, &sim->admission_times);
+    write_snapshot_histogram(file, &sim->lateness_times);
+    write_snapshot_int(file, sim->num_deadlines);
+    write_snapshot_int(file, sim->num_missed_deadlines);
+    write_snapshot_double(file, sim->periodic_utilization);
+    write_snapshot_int(file, sim->num_periodic);
+    for (int slot = 0; slot < sim->periodic_capacity; slot++) {
+        if (sim->periodic_pids[slot] != LLONG_MAX) {
+            write_snapshot_int(file, sim->periodic_pids[slot]);
+        }
+    }
+    write_snapshot_int(file, sim->memory->page_references);
+    write_snapshot_int(file, sim->memory->page_faults);
+
+    // Processes that have not arrived yet, in order of arrival
+    write_snapshot_int(file, sim->workload_size - sim->next_arrival);
+    for (int i = sim->next_arrival; i < sim->workload_size; i++) {
+        const sim_process_t *process = workload_process(sim, i);
+        write_snapshot_int(file, process->pid);
+        write_snapshot_int(file, process->arrival_time);
+        write_snapshot_int(file, process->total_cpu_time);
+        write_snapshot_int(file, process->io_frequency);
+        write_snapshot_int(file, process->io_duration);
+        write_snapshot_int(file, process->priority);
+        write_snapshot_int(file, process->size_of_process);
+        write_snapshot_int(file, process->deadline);
+        write_snapshot_int(file, process->period);
+    }
+
+    // The pcbs of each queue, numbered in the order they are written
+    queue_t **queues = malloc((2 * sim->config.num_cpus + 5) * sizeof(queue_t *));
+    int *number = malloc((sim->pool->size > 0 ? sim->pool->size : 1) * sizeof(int));
+    assert((queues != NULL) && (number != NULL));
+    for (int index = 0; index < sim->pool->size; index++) {
+        number[index] = -1;
+    }
+    int num_pcbs = 0;
+    int num_queues = snapshot_queues(sim, queues);
+    for (int q = 0; q < num_queues; q++) {
+        int *order = queue_order(queues[q]);
+        write_snapshot_int(file, queues[q]->size);
+        for (int i = 0; i < queues[q]->size; i++) {
+            number[order[i]] = num_pcbs++;
+            write_snapshot_pcb(file, &sim->pool->pcbs[order[i]]);
+        }
+        free(order);
+    }
+
+    write_snapshot_memory(file, sim, number);
+    free(number);
+    free(queues);
+    return (fflush(file) == 0) && !ferror(file);
+}
+
+static int compare_admission_times(const void *a, const void *b) {
+    /*
+     * Orders pairs of an admission time and a pool index by admission time, then by index.
+     */
+
+    const int *x = a;
+    const int *y = b;
+    if (x[0] != y[0]) {
+        return (x[0] < y[0]) ? -1 : 1;
+    }
+    return (x[1] > y[1]) - (x[1] < y[1]);
+}
+
+static _Bool reallocate_memory(sim_t *sim, int first_admitted, int num_pcbs) {
+    /*
+     * Gives memory again to the restored pcbs that held memory in the snapshot, when the memory they held is
+     * not the memory of the simulation. They are the pcbs from first_admitted on that are not swapped out, and
+     * they get memory in the order they were admitted. Returns false if one of them does not fit.
+     */
+
+    for (int index = 0; index < num_pcbs; index++) {
+        pcb_t *pcb = &sim->pool->pcbs[index];
+        free(pcb->page_table);
+        pcb->page_table = NULL;
+        pcb->num_pages = 0;
+        pcb->page_read_in = false;
+        pcb->trace_length = 0;
+        pcb->base_memory_location = -1;
+    }
+    if (!sim->use_memory_management) {
+        return true;
+    }
+
+    int (*admitted)[2] = malloc(((num_pcbs > 0) ? num_pcbs : 1) * sizeof(int[2]));
+    assert(admitted != NULL);
+    int num_admitted = 0;
+    for (int index = first_admitted; index < num_pcbs; index++) {
+        if (!sim->pool->pcbs[index].swapped_out) {
+            admitted[num_admitted][0] = sim->pool->pcbs[index].admission_time;
+            admitted[num_admitted][1] = index;
+            num_admitted++;
+        }
+    }
+    qsort(admitted, num_admitted, sizeof(int[2]), compare_admission_times);
+    for (int i = 0; i < num_admitted; i++) {
+        pcb_t *pcb = &sim->pool->pcbs[admitted[i][1]];
+        if (!allocate_memory(pcb, sim->memory, NULL)) {
+            printf("\nERROR >>> Process %d holds memory in the snapshot but does not fit in the memory it is "
+                   "restored with\n", pcb->pid);
+            free(admitted);
+            return false;
+        }
+    }
+    free(admitted);
+    return true;
+}
+
+static _Bool read_snapshot(snapshot_reader_t *reader, sim_t *sim) {
+    /*
+     * Reads the rest of a snapshot after its header into a simulation just made by sim_create, as described
+     * at sim_restore. Returns false, after printing why, if it cannot be restored.
+     */
+
+    // Settings and metrics
+    int scheduler_type = read_snapshot_range(reader, 0, 8);
+    _Bool oracle_burst = read_snapshot_range(reader, 0, 1);
+    int num_cpus = read_snapshot_range(reader, 1, INT_MAX);
+    if (!reader->failed && (num_cpus != sim->config.num_cpus)) {
+        printf("\nERROR >>> The snapshot has %d cores and has to be restored with as many\n", num_cpus);
+        return false;
+    }
+    sim->min_vruntime = read_snapshot_int(reader);
+    sim->num_processes = (int) read_snapshot_int(reader);
+    sim->num_terminated = (int) read_snapshot_int(reader);
+    sim->total_cpu_burst_time = read_snapshot_int(reader);
+    sim->total_turnaround_time = read_snapshot_int(reader);
+    sim->total_waiting_time = read_snapshot_int(reader);
+    sim->total_time_between_io = read_snapshot_int(reader);
+    sim->num_io = (int) read_snapshot_int(reader);
+    sim->num_transitions = read_snapshot_int(reader);
+    for (int core = 0; core < sim->config.num_cpus; core++) {
+        sim->cpu_busy_time[core] = (int) read_snapshot_int(reader);
+    }
+    sim->num_swap_outs = (int) read_snapshot_int(reader);
+    sim->num_swap_ins = (int) read_snapshot_int(reader);
+    sim->swap_traffic = read_snapshot_int(reader);
+    read_snapshot_histogram(reader, &sim->turnaround_times);
+    read_snapshot_histogram(reader, &sim->waiting_times);
+    read_snapshot_histogram(reader, &sim->response_times);
+    read_snapshot_histogram(reader, &sim->admission_times);
+    read_snapshot_histogram(reader, &sim->lateness_times);
+    sim->num_deadlines = (int) read_snapshot_int(reader);
+    sim->num_missed_deadlines = (int) read_snapshot_int(reader);
+    sim->periodic_utilization = read_snapshot_double(reader);
+    int num_periodic = read_snapshot_range(reader, 0, INT_MAX);
+    for (int i = 0; (i < num_periodic) && !reader->failed; i++) {
+        add_periodic_task(sim, (int) read_snapshot_int(reader));
+        sim->num_periodic++;
+    }
+    sim->memory->page_references = read_snapshot_int(reader);
+    sim->memory->page_faults = read_snapshot_int(reader);
+
+    // Processes that have not arrived yet, which have to fit in the memory they are restored with
+    int num_pending = read_snapshot_range(reader, 0, INT_MAX);
+    sim->restored_workload = malloc((num_pending > 0 ? num_pending : 1) * sizeof(sim_process_t));
+    assert(sim->restored_workload != NULL);
+    for (int i = 0; (i < num_pending) && !reader->failed; i++) {
+        sim_process_t *process = &sim->restored_workload[i];
+        process->pid = (int) read_snapshot_int(reader);
+        process->arrival_time = (int) read_snapshot_int(reader);
+        process->total_cpu_time = (int) read_snapshot_int(reader);
+        process->io_frequency = (int) read_snapshot_int(reader);
+        process->io_duration = (int) read_snapshot_int(reader);
+        process->priority = (int) read_snapshot_int(reader);
+        process->size_of_process = (int) read_snapshot_int(reader);
+        process->deadline = (int) read_snapshot_int(reader);
+        process->period = (int) read_snapshot_int(reader);
+    }
+    if (reader->failed) {
+        return true;        // sim_restore reports the snapshot as corrupt
+    }
+    if (!error_handling(sim->restored_workload, num_pending, sim->memory, sim->use_memory_management)) {
+        return false;
+    }
+    sim->workload = sim->restored_workload;
+    sim->workload_size = num_pending;
+
+    // The pcbs of each queue, which get the pool indices they were numbered with
+    queue_t **queues = malloc((2 * sim->config.num_cpus + 5) * sizeof(queue_t *));
+    assert(queues != NULL);
+    int num_queues = snapshot_queues(sim, queues);
+    int *queue_sizes = malloc(num_queues * sizeof(int));
+    assert(queue_sizes != NULL);
+    int num_pcbs = 0;
+    for (int q = 0; q < num_queues; q++) {
+        _Bool running = (q > num_cpus) && (q <= 2 * num_cpus);    // A core runs one process at most
+        queue_sizes[q] = read_snapshot_range(reader, 0, running ? 1 : INT_MAX);
+        for (int i = 0; (i < queue_sizes[q]) && !reader->failed; i++) {
+            read_snapshot_pcb(reader, sim->pool);
+            num_pcbs++;
+        }
+    }
+    for (int index = 0; !reader->failed && (index < num_pcbs); index++) {
+        if (sim->pool->pcbs[index].swapped_out && !sim->config.swapping) {
+            printf("\nERROR >>> Process %d is swapped out in the snapshot, which has to be restored with "
+                   "swapping\n", sim->pool->pcbs[index].pid);
+            free(queue_sizes);
+            free(queues);
+            return false;
+        }
+    }
+
+    // The processes that were admitted have to fit the page trace the snapshot is restored with
+    for (int index = 0; sim->paging && !reader->failed && (index < num_pcbs); index++) {
+        pcb_t *pcb = &sim->pool->pcbs[index];
+        if ((index >= queue_sizes[0]) && !page_trace_fits(sim->memory, pcb->pid,
+                             (pcb->size_of_process + sim->memory->page_size - 1) / sim->memory->page_size)) {
+            free(queue_sizes);
+            free(queues);
+            return false;
+        }
+    }
+
+    // A scheduler the pcbs did not run under starts them off fresh
+    for (int index = 0; index < num_pcbs; index++) {
+        pcb_t *pcb = &sim->pool->pcbs[index];
+        if (pcb->level >= sim->config.num_levels) {
+            pcb->level = (sim->config.num_levels > 0) ? sim->config.num_levels - 1 : 0;
+        }
+        if ((sim->config.scheduler_type == 4) && (scheduler_type != 4)) {
+            pcb->vruntime = 0;
+            pcb->charged_cpu_time = pcb->remaining_cpu_time;
+            sim->min_vruntime = 0;
+        }
+        if (((sim->config.scheduler_type == 5) || (sim->config.scheduler_type == 6)) &&
+            (((scheduler_type != 5) && (scheduler_type != 6)) || (oracle_burst != sim->config.oracle_burst))) {
+            if ((scheduler_type != 5) && (scheduler_type != 6)) {
+                pcb->predicted_burst = sim->config.initial_burst;
+                pcb->burst_start_cpu_time = pcb->remaining_cpu_time;
+            }
+            pcb->expected_burst = expected_burst(sim, pcb);
+        }
+    }
+
+    // The memory as it was, or else memory given again to the processes that held some
+    _Bool restored = true;
+    if (!reader->failed && !read_snapshot_memory(reader, sim, num_pcbs) && !reader->failed) {
+        restored = reallocate_memory(sim, queue_sizes[0], num_pcbs);
+    }
+
+    // Enqueueing the pcbs in the order they were written gives back each queue. The blocked processes become
+    // swap candidates in that order too, which keeps the later of two equal ranks the later one.
+    int index = 0;
+    for (int q = 0; (q < num_queues) && restored && !reader->failed; q++) {
+        for (int i = 0; i < queue_sizes[q]; i++) {
+            pcb_t *pcb = &sim->pool->pcbs[index++];
+            enqueue(queues[q], pcb);
+            if (queues[q] == sim->waiting) {
+                add_swap_candidate(sim, pcb, pcb->io_completion_time);
+            } else if (queues[q] == sim->io_backlog) {
+                add_swap_candidate(sim, pcb, LLONG_MAX);
+            }
+        }
+    }
+    free(queue_sizes);
+    free(queues);
+    return restored;
+}
+
+sim_t *sim_restore(FILE *file, const sim_config_t *config) {
+    /*
+     * Reads a snapshot written by sim_save and returns a simulation that goes on from it under the given
+     * settings, which may differ from those of the saved simulation but for the number of cores. Returns NULL
+     * if the settings are not valid, or, after printing why, if the snapshot cannot be restored under them.
+     * - Processes keep their place in the queues. A scheduler they did not run under starts them off fresh:
+     *   CFS virtual runtimes start over from 0, SJF predictions from the initial burst, and MLFQ levels are
+     *   kept within the levels there are.
+     * - The same memory is restored as it was. Any other memory is given again to the processes that held
+     *   memory, in the order they were admitted, which fails if one of them does not fit.
+     * - Swapped out processes can only be restored with swapping, and the page trace given has to fit the
+     *   processes that were admitted.
+     * - Sampling, under the sample interval given, goes on from the first sample time at or after the time
+     *   of the snapshot, the samples before it belong to the saved simulation.
+     * The restored simulation holds the processes that had not arrived yet, so it needs no sim_load, and its
+     * output and callbacks are set as for any other simulation.
+     */
+
+    sim_t *sim = sim_create(config);
+    if (sim == NULL) {
+        return NULL;
+    }
+
+    unsigned char header[SNAPSHOT_HEADER_SIZE];
+    if ((fread(header, 1, sizeof(header), file) != sizeof(header)) || (memcmp(header, SIM_SNAPSHOT_MAGIC, 4) != 0)) {
+        printf("\nERROR >>> The file is not a snapshot\n");
+        sim_destroy(sim);
+        return NULL;
+    }
+    int version = header[4] | (header[5] << 8) | (header[6] << 16) | (header[7] << 24);
+    if (version != SNAPSHOT_VERSION) {
+        printf("\nERROR >>> The snapshot is of version %d, only version %d can be restored\n", version,
+               SNAPSHOT_VERSION);
+        sim_destroy(sim);
+        return NULL;
+    }
+    sim->time_elapsed = (int) ((unsigned int) header[8] | ((unsigned int) header[9] << 8) |
+                               ((unsigned int) header[10] << 16) | ((unsigned int) header[11] << 24));
+    if (sim->config.sample_interval > 0) {
+        long long interval = sim->config.sample_interval;
+        long long next_sample_time = (sim->time_elapsed + interval - 1) / interval * interval;
+        sim->next_sample_time = (next_sample_time < INT_MAX) ? (int) next_sample_time : INT_MAX;
+    }
+
+    snapshot_reader_t reader = {file, false};
+    _Bool restored = read_snapshot(&reader, sim);
+    if (restored && reader.failed) {
+        printf("\nERROR >>> The snapshot is truncated or corrupt\n");
+    }
+    if (!restored || reader.failed) {
+        for (int index = 0; index < sim->pool->size; index++) {
+            free(sim->pool->pcbs[index].page_table);
+        }
+        sim_destroy(sim);
+        return NULL;
+    }
+    return sim;
+}
+
+
+
+// Workload generator
+
+void sim_default_generator(sim_generator_t *generator) {
+    /*
+     * Fills in the default workload: Poisson arrivals every 50 ms on average, exponential CPU times of 40 ms on
+     * average and half of the processes doing I/O. A single core with one I/O device keeps up with it, so the
+     * queues stay short however many processes there are.
+     */
+
+    generator->seed = 1;
+    generator->arrivals = POISSON_ARRIVALS;
+    generator->interarrival_time = 50;
+    generator->burst_size = 10;
+    generator->cpu_time = (sim_distribution_t) {EXPONENTIAL_DISTRIBUTION, 40};
+    generator->io_frequency = (sim_distribution_t) {EXPONENTIAL_DISTRIBUTION, 20};
+    generator->io_duration = (sim_distribution_t) {EXPONENTIAL_DISTRIBUTION, 25};
+    generator->io_fraction = 0.5;
+    generator->num_priorities = 10;
+    generator->min_size = 1;
+    generator->max_size = 100;
+}
+
+static double random_fraction(unsigned int *state) {
+    /*
+     * Moves the xorshift state on and returns a fraction spread uniformly between 0 (included) and 1.
+     */
+
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (*state >> 8) / 16777216.0;
+}
+
+static int random_time(unsigned int *state, const sim_distribution_t *distribution) {
+    /*
+     * Draws a time of at least 1 ms from the distribution.
+     */
+
+    double time = distribution->mean;
+    if (distribution->type == UNIFORM_DISTRIBUTION) {
+        time = 1 + random_fraction(state) * (2 * distribution->mean - 1);
+    } else if (distribution->type == EXPONENTIAL_DISTRIBUTION) {
+        time = -distribution->mean * log(1 - random_fraction(state));
+    }
+    return (time < 1.5) ? 1 : (int) (time + 0.5);
+}
+
+sim_process_t *sim_generate(const sim_generator_t *generator, int num_processes) {
+    /*
+     * Returns a new array of num_processes processes, in order of arrival time, with pids counting from 1. The
+     * time between arrivals is exponential, with bursty arrivals it is the time between bursts, and the number
+     * of processes in each burst is geometric. Returns NULL if the settings are not valid. The caller frees the
+     * array.
+     */
+
+    const sim_distribution_t *distributions[] = {&generator->cpu_time, &generator->io_frequency,
+                                                  &generator->io_duration};
+    for (int i = 0; i < 3; i++) {
+        if ((distributions[i]->type < CONSTANT_DISTRIBUTION) || (distributions[i]->type > EXPONENTIAL_DISTRIBUTION) ||
+            !(distributions[i]->mean >= 1)) {
+            return NULL;
+        }
+    }
+    if ((num_processes < 0) || !(generator->interarrival_time >= 0) || !(generator->burst_size >= 1) ||
+        (generator->arrivals < POISSON_ARRIVALS) || (generator->arrivals > BURSTY_ARRIVALS) ||
+        !(generator->io_fraction >= 0) || !(generator->io_fraction <= 1) || (generator->num_priorities < 1) ||
+        (generator->min_size < 0) || (generator->max_size < generator->min_size)) {
+        return NULL;
+    }
+
+    sim_process_t *processes = malloc((num_processes > 0 ? num_processes : 1) * sizeof(sim_process_t));
+    assert(processes != NULL);
+    unsigned int state = (generator->seed != 0) ? generator->seed : 2463534242u;   // xorshift never leaves 0
+    double time = 0;
+    int burst_left = 0;     // Processes still to arrive with the current burst
+
+    for (int i = 0; i < num_processes; i++) {
+        if (generator->arrivals == POISSON_ARRIVALS) {
+            time -= generator->interarrival_time * log(1 - random_fraction(&state));
+        } else if (burst_left == 0) {
+            time -= generator->interarrival_time * generator->burst_size * log(1 - random_fraction(&state));
+            burst_left = 1;
+            while (random_fraction(&state) >= 1 / generator->burst_size) {
+                burst_left++;
+            }
+        }
+        burst_left = (burst_left > 0) ? burst_left - 1 : 0;
+        assert(time < 2147483647.0);
+
+        sim_process_t *process = &processes[i];
+        process->pid = i + 1;
+        process->arrival_time = (int) time;
+        process->total_cpu_time = random_time(&state, &generator->cpu_time);
+        process->io_frequency = 0;
+        process->io_duration = 0;
+        if (random_fraction(&state) < generator->io_fraction) {
+            process->io_frequency = random_time(&state, &generator->io_frequency);
+            process->io_duration = random_time(&state, &generator->io_duration);
+        }
+        process->priority = (int) (random_fraction(&state) * generator->num_priorities);
+        process->size_of_process = generator->min_size +
+                                   (int) (random_fraction(&state) * (generator->max_size - generator->min_size + 1));
+        process->deadline = 0;
+        process->period = 0;
+    }
+    return processes;
+}
+
+static int perturb_time(unsigned int *state, int time, double spread) {
+    /*
+     * Scales a time by a random factor spread uniformly from 1 - spread to 1 + spread, keeping it at least 1 ms.
+     */
+
+    double scaled = time * (1 - spread + 2 * spread * random_fraction(state));
+    if (scaled >= INT_MAX) {
+        return INT_MAX;
+    }
+    return (scaled < 1.5) ? 1 : (int) (scaled + 0.5);
+}
+
+_Bool sim_perturb(sim_process_t processes[], int num_processes, double spread, unsigned int seed) {
+    /*
+     * Scales the CPU time and the I/O duration of each process by a factor of its own, drawn uniformly from
+     * 1 - spread to 1 + spread, to make one replica of a workload for Monte Carlo runs. The same seed always
+     * gives the same replica, and consecutive seeds give unrelated ones. Returns false, leaving the processes
+     * as they were, if spread is not from 0 to 1.
+     */
+
+    if (!(spread >= 0) || !(spread < 1)) {
+        return false;
+    }
+
+    // Consecutive seeds are spread over the whole state before xorshift, which never leaves 0, mixes them further
+    unsigned int state = seed * 2654435769u;
+    state = (state != 0) ? state : 2463534242u;
+    for (int i = 0; i < 4; i++) {
+        random_fraction(&state);
+    }
+
+    for (int i = 0; i < num_processes; i++) {
+        processes[i].total_cpu_time = perturb_time(&state, processes[i].total_cpu_time, spread);
+        if (processes[i].io_duration > 0) {
+            processes[i].io_duration = perturb_time(&state, processes[i].io_duration, spread);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,188 @@
+/** Kernel Simulator - Assignment 2, Part II
+ *
+ * Carleton University
+ * Department of System and Computer Engineering
+ * SYSC 4001 - Operating Systems
+ *
+ * @authors			Trong Nguyen, 100848232
+ * 				Evan Smedley, 101148695
+ * @version			1.0
+ * @release			March 5, 2021
+ *
+ * Interface of the simulator library. Each simulation is a sim_t that owns its queues, memory, clock and
+ * metrics, and nothing is shared between simulations, so any number of them can run side by side in different
+ * threads. A simulation is driven entirely in memory: the workload is handed over as an array, or one process at
+ * a time through a callback, and the transitions only reach a file if the caller gives the simulation one.
+ * The whole state of a simulation can be saved to a snapshot at any time between two steps, and restored later
+ * as a new simulation, under the same settings or others, to fork several runs off a common start.
+ *
+ *     sim_config_t config;
+ *     sim_default_config(&config);
+ *     sim_t *sim = sim_create(&config);
+ *     sim_load(sim, processes, num_processes);
+ *     sim_run_until(sim, SIM_FOREVER);
+ *     sim_metrics_t metrics = sim_metrics(sim);
+ *     sim_destroy(sim);
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdio.h>
+
+
+
+enum { FIRST_FIT, BEST_FIT, NEXT_FIT, WORST_FIT };          // Hole picking policies of dynamic partitions
+enum { FIFO_REPLACEMENT, LRU_REPLACEMENT, CLOCK_REPLACEMENT, ARC_REPLACEMENT };  // Page replacement policies
+enum { CONSTANT_DISTRIBUTION, UNIFORM_DISTRIBUTION, EXPONENTIAL_DISTRIBUTION };  // Distributions of generated times
+enum { POISSON_ARRIVALS, BURSTY_ARRIVALS }; // How generated processes arrive
+enum { MAX_LEVELS = 32 };   // Most ready queue levels an MLFQ can have
+enum { NUM_SCHEDULERS = 9, NUM_MEMORY_MODES = 6 };  // Scheduler types and memory modes count from 0
+enum { SIM_FOREVER = -1 };  // Time given to sim_run_until to run a simulation until every process has terminated
+#define SIM_SNAPSHOT_MAGIC "KSSN"   // First four bytes of a snapshot written by sim_save
+
+typedef struct sim sim_t;   // Defines the whole state of a simulation, only ever handled through a pointer
+
+typedef struct {            // Defines the settings of a simulation
+    int scheduler_type;     // 0 for FCFS, 1 for external priorities, 2 for round robin, 3 for MLFQ, 4 for CFS,
+                            // 5 for SJF, 6 for SRTF, 7 for EDF, 8 for rate monotonic
+    int quantum;            // Only used by round robin, and by MLFQ as the quantum of its top level
+    int num_levels;         // MLFQ settings: number of ready queue levels
+    int level_quanta[MAX_LEVELS];   // Quantum of each level, 0 for twice the quantum of the level above
+    int boost_interval;     // Every process goes back to the top level this often in ms, 0 to never boost
+    int target_latency;     // CFS settings: time in ms in which every runnable process of a core should run
+    int min_granularity;    // Shortest timeslice in ms
+    double burst_alpha;     // SJF and SRTF settings: weight of the last CPU burst in the burst prediction
+    int initial_burst;      // Predicted first CPU burst of each process in ms
+    _Bool oracle_burst;     // Use the real CPU bursts instead of predicting them
+    int sample_interval;    // Time in ms between time series samples, 0 to not sample
+    int sample_buffer;      // Number of samples the ring buffer holds
+    _Bool swapping;         // Swap blocked processes out to admit new ones, with memory modes 1 to 4
+    int swap_time;          // Time in ms to write a process to the backing store or to read it back
+    int memory_mode;        // 0 for no memory management, otherwise the memory management mode argument
+    _Bool event_driven;     // Jump from one event to the next instead of stepping through every tick
+    int io_devices;         // Number of processes that can be served for I/O at once, 0 for no limit
+    int num_cpus;           // Number of cores, each with its own running and ready queue
+    int fit;                // How dynamic partitions pick the hole a process goes into
+    int memory_size;        // Size of the memory in Mb for dynamic partitions and the buddy system, 0 for the default
+    int num_frames;         // Paging settings
+    int page_size;
+    int replacement;
+    int fault_time;
+    int access_time;
+    const char *page_trace; // File of page references, NULL to generate them
+} sim_config_t;
+
+typedef struct {            // Defines a process of a workload, one line of an input file
+    int pid;
+    int arrival_time;
+    int total_cpu_time;
+    int io_frequency;
+    int io_duration;
+    int priority;
+    int size_of_process;
+    int deadline;           // Time in ms after its arrival by which the process should terminate, 0 for none
+    int period;             // Period in ms of a periodic process, 0 for none, also its deadline if it has none
+} sim_process_t;
+
+typedef struct {            // Defines the percentiles of a time of the terminated processes, in ms
+    int p50;
+    int p90;
+    int p99;
+    int p999;
+    int max;
+} sim_percentiles_t;
+
+typedef struct {            // Defines the metrics of a simulation so far
+    int time_elapsed;
+    int num_processes;      // Processes that have arrived
+    int num_terminated;
+    long long total_cpu_burst_time;
+    long long total_turnaround_time;
+    long long total_waiting_time;
+    long long total_time_between_io;
+    int num_io;
+    long long num_transitions;
+    int num_cpus;
+    const int *cpu_busy_time;   // Ticks each core spent executing a process, valid until the simulation moves on
+    _Bool paging;
+    long long page_references;
+    long long page_faults;
+    _Bool swapping;
+    int num_swap_outs;
+    int num_swap_ins;
+    long long swap_traffic; // Mb written to and read from the backing store
+    sim_percentiles_t turnaround_time;
+    sim_percentiles_t waiting_time;     // Time spent in the ready queue
+    sim_percentiles_t response_time;    // Time from arrival until first running
+    sim_percentiles_t admission_time;   // Time from arrival until admitted, waiting for memory
+    int num_deadlines;      // Terminated processes that had a deadline
+    int num_missed_deadlines;
+    sim_percentiles_t lateness;         // Time from its deadline until a process terminated, 0 if it was on time
+    int num_periodic;       // Periodic tasks that have arrived, the jobs of a task share its pid
+    double periodic_utilization;        // Sum of the CPU time over the period of each of them
+} sim_metrics_t;
+
+typedef struct {            // Defines the distribution of a time of generated processes
+    int type;
+    double mean;            // In ms, a uniform distribution goes from 1 to twice the mean
+} sim_distribution_t;
+
+typedef struct {            // Defines the workloads made by sim_generate
+    unsigned int seed;      // The same settings and seed always give the same workload
+    int arrivals;
+    double interarrival_time;   // Mean time between arrivals in ms, arrivals are exponentially spread out
+    double burst_size;      // Mean number of processes arriving at once with bursty arrivals
+    sim_distribution_t cpu_time;
+    sim_distribution_t io_frequency;
+    sim_distribution_t io_duration;
+    double io_fraction;     // Fraction of the processes that do I/O, the others have an I/O frequency of 0
+    int num_priorities;     // Priorities go from 0 to num_priorities - 1
+    int min_size;           // Memory of each process in Mb, uniformly spread out
+    int max_size;
+} sim_generator_t;
+
+typedef struct {            // Defines a time series sample, taken at the start of a tick
+    int time;
+    int new_size;           // Processes waiting to be admitted
+    int ready_size;         // Ready processes across all cores
+    int waiting_size;       // Processes being served by an I/O device or waiting for one
+    int busy_cpus;
+    int used_portions;      // Processes holding memory, 0 without memory management
+    int free_usable_memory; // Memory in Mb that can still be given to processes, 0 without memory management
+} sim_sample_t;
+
+// Gives the next process to arrive, returns false once there are none left
+typedef _Bool (*sim_next_process_t)(void *context, sim_process_t *process);
+
+// Receives the samples in order whenever the ring buffer fills up
+typedef void (*sim_on_samples_t)(void *context, const sim_sample_t samples[], int num_samples);
+
+// Receives each transition as it happens, with the identifiers listed at sim_write_transition
+typedef void (*sim_on_transition_t)(void *context, int transition_identifier, int time, int pid);
+
+
+
+void sim_default_config(sim_config_t *config);
+sim_t *sim_create(const sim_config_t *config);
+_Bool sim_load(sim_t *sim, const sim_process_t processes[], int num_processes);
+void sim_stream(sim_t *sim, sim_next_process_t next_process, void *context);
+void sim_set_output(sim_t *sim, FILE *output);
+void sim_set_process_log(sim_t *sim, FILE *log);
+void sim_set_transition_callback(sim_t *sim, sim_on_transition_t on_transition, void *context);
+void sim_set_sample_callback(sim_t *sim, sim_on_samples_t on_samples, void *context);
+int sim_samples(const sim_t *sim, sim_sample_t samples[]);
+void sim_flush_samples(sim_t *sim);
+_Bool sim_step(sim_t *sim);
+_Bool sim_run_until(sim_t *sim, int time);
+_Bool sim_finished(const sim_t *sim);
+sim_metrics_t sim_metrics(const sim_t *sim);
+_Bool sim_save(const sim_t *sim, FILE *file);
+sim_t *sim_restore(FILE *file, const sim_config_t *config);
+void sim_destroy(sim_t *sim);
+void sim_write_transition(FILE *write_file, int transition_identifier, int time, int pid);
+void sim_default_generator(sim_generator_t *generator);
+sim_process_t *sim_generate(const sim_generator_t *generator, int num_processes);
+_Bool sim_perturb(sim_process_t processes[], int num_processes, double spread, unsigned int seed);
+
+#endif